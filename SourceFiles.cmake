@@ -22,6 +22,45 @@ set(SourceFiles
     src/jucex/valuetree/VariantConverter.h
     src/PluginEditor.h
     src/core/Scale.h
+    src/core/BlockTiming.h
+    src/core/BlockTiming.cpp
+    src/core/TempoMap.h
+    src/core/TempoMap.cpp
+    src/core/Arpeggiator.h
+    src/core/Arpeggiator.cpp
+    src/core/MidiRecorder.h
+    src/core/MidiRecorder.cpp
+    src/core/MidiThru.h
+    src/core/MidiThru.cpp
+    src/core/TripleBuffer.h
+    src/core/SeqLock.h
+    src/core/ScaleTable.h
+    src/core/ScaleTable.cpp
+    src/core/KeyboardControl.h
+    src/core/KeyboardControl.cpp
+    src/core/MidiClockGenerator.h
+    src/core/MidiClockGenerator.cpp
+    src/core/MidiEventQueue.h
+    src/core/MidiEventQueue.cpp
+    src/core/MidiBufferUtils.h
+    src/core/MidiBufferUtils.cpp
+    src/core/ClockTempoEstimator.h
+    src/core/ClockTempoEstimator.cpp
+    src/core/MidiClockInput.h
+    src/core/MidiClockInput.cpp
+    src/core/Groove.h
+    src/core/Groove.cpp
+    src/core/Humanize.h
+    src/core/Humanize.cpp
+    src/core/Parameters.h
+    src/core/Parameters.cpp
+    src/core/ChangeDispatcher.h
+    src/core/ChangeDispatcher.cpp
+    src/core/UndoHistory.h
+    src/core/SlotMap.h
+    src/core/TrackList.h
+    src/core/TrackList.cpp
+    src/core/UndoHistory.cpp
     src/core/StepProcessor.h
     src/core/TimingManager.cpp
     src/core/Sequencer.cpp
@@ -40,6 +79,8 @@ set(SourceFiles
     src/core/TriggerBuffer.cpp
     src/core/InternalTransport.h
     src/core/TriggerBuffer.h
+    src/core/TriggerTable.cpp
+    src/core/TriggerTable.h
     src/core/Scale.cpp
     src/core/StepProcessor.cpp
     src/core/TimingManager.h
@@ -0,0 +1,79 @@
+#include "core/MidiEventQueue.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+using Sirkus::Core::MidiEventQueue;
+
+namespace {
+
+constexpr int NUM_TRACKS = 16;
+constexpr int BLOCK_SAMPLES = 512;
+
+// numEvents note ons, added a track at a time as the engine adds them, so the queue holds
+// one ordered run per track interleaved across the block
+void fill(MidiEventQueue& queue, const int numEvents)
+{
+    const int perTrack = numEvents / NUM_TRACKS;
+    for (int track = 0; track < NUM_TRACKS; ++track)
+    {
+        for (int i = 0; i < perTrack; ++i)
+        {
+            const juce::uint8 noteOn[] = {
+                static_cast<juce::uint8>(0x90 | track),
+                static_cast<juce::uint8>(36 + i % 64),
+                100};
+            queue.addEvent(noteOn, 3, (i * BLOCK_SAMPLES) / perTrack + track % 4);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Writing a block's events costs the same per event however many there are", "[benchmark][midi]")
+{
+    // Divide by the event count for the cost of one event, which should stay flat
+    for (const int numEvents : {256, 1024, 4096, 16384})
+    {
+        MidiEventQueue queue;
+        queue.prepare(static_cast<size_t>(numEvents), static_cast<size_t>(numEvents) * 3);
+
+        juce::MidiBuffer midiOut;
+        midiOut.ensureSize(static_cast<size_t>(queue.getMidiBufferBytes()));
+
+        BENCHMARK(std::to_string(numEvents) + " events")
+        {
+            fill(queue, numEvents);
+            queue.writeTo(midiOut);
+            return midiOut.getNumEvents();
+        };
+    }
+}
+
+TEST_CASE("Adding a block's events one at a time grows with the square of the count", "[benchmark][midi]")
+{
+    // For comparison, what writing each event with MidiBuffer::addEvent costs
+    for (const int numEvents : {256, 1024, 4096})
+    {
+        MidiEventQueue queue;
+        queue.prepare(static_cast<size_t>(numEvents), static_cast<size_t>(numEvents) * 3);
+        fill(queue, numEvents);
+
+        juce::MidiBuffer sorted;
+        sorted.ensureSize(static_cast<size_t>(queue.getMidiBufferBytes()));
+        queue.writeTo(sorted);
+
+        juce::MidiBuffer midiOut;
+        midiOut.ensureSize(static_cast<size_t>(queue.getMidiBufferBytes()));
+
+        BENCHMARK(std::to_string(numEvents) + " events with addEvent")
+        {
+            midiOut.clear();
+            for (const auto metadata : sorted)
+                midiOut.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+            return midiOut.getNumEvents();
+        };
+    }
+}
@@ -0,0 +1,128 @@
+#include "core/Arpeggiator.h"
+#include "core/BlockTiming.h"
+#include "core/MidiEventQueue.h"
+#include "core/Scale.h"
+#include "core/ScaleTable.h"
+#include "core/StepProcessor.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using Sirkus::Core::ActiveStep;
+using Sirkus::Core::Arpeggiator;
+using Sirkus::Core::BlockTiming;
+using Sirkus::Core::MidiEventQueue;
+using Sirkus::Core::Scale;
+using Sirkus::Core::ScaleMode;
+using Sirkus::Core::ScaleTable;
+using Sirkus::Core::StepProcessor;
+using Sirkus::Core::TrackInfo;
+
+namespace {
+
+constexpr double SAMPLE_RATE = 48000.0;
+constexpr int BLOCK_SAMPLES = 2048; // 80 ticks at 120 BPM
+
+BlockTiming makeTiming()
+{
+    int64_t rateTicks = 0;
+    int64_t rateSamples = 0;
+    BlockTiming::tempoToRate(120.0, SAMPLE_RATE, rateTicks, rateSamples);
+    return BlockTiming::fromRate(0, 0, rateTicks, rateSamples, BLOCK_SAMPLES);
+}
+
+// numSteps triggers spread over the block, stacked on the same ticks once there are more
+// steps than ticks. Every other one has a probability below 1 when withProbability is set
+std::vector<ActiveStep> makeSteps(const int numSteps, const BlockTiming& timing, const bool withProbability)
+{
+    const auto blockTicks = static_cast<int>(timing.endTick - timing.startTick);
+
+    std::vector<ActiveStep> steps;
+    steps.reserve(static_cast<size_t>(numSteps));
+    for (int i = 0; i < numSteps; ++i)
+    {
+        ActiveStep active{};
+        active.tick = static_cast<int>(timing.startTick) + i % blockTicks;
+        active.triggerTick = active.tick;
+        active.note = static_cast<uint8_t>(36 + i % 48);
+        active.length = 1;
+        active.probability = withProbability && i % 2 == 0 ? 0.5f : 1.0f;
+        steps.push_back(active);
+    }
+
+    return steps;
+}
+
+} // namespace
+
+TEST_CASE("Processing a block's steps at high densities", "[benchmark][steps]")
+{
+    const auto timing = makeTiming();
+    const auto scale = ScaleTable::fromScale(Scale(Scale::Type::Minor, 2));
+
+    StepProcessor processor;
+    processor.prepare(1);
+
+    // Room for a note-on and note-off per step at the highest density
+    MidiEventQueue midiOut;
+    midiOut.prepare(8192, 8192 * 3);
+
+    const std::pair<const char*, ScaleMode> scaleModes[] = {
+        {"scale off", ScaleMode::Off},
+        {"quantize up", ScaleMode::QuantizeUp},
+        {"quantize random", ScaleMode::QuantizeRandom},
+    };
+
+    // One kernel per configuration, so the cost per step should stay flat as the density
+    // rises and the configurations should differ only by the work each one adds
+    for (const int numSteps : {16, 256, 1024, 4096})
+    {
+        for (const bool withProbability : {false, true})
+        {
+            const auto steps = makeSteps(numSteps, timing, withProbability);
+            for (const auto& [name, scaleMode] : scaleModes)
+            {
+                const TrackInfo trackInfo{1, 1, scaleMode};
+                BENCHMARK(
+                    std::to_string(numSteps) + " steps, " + name + (withProbability ? ", probability" : ""))
+                {
+                    midiOut.clear();
+                    processor.processSteps(steps, trackInfo, scale, timing, midiOut);
+                    processor.flushNoteOffs(midiOut);
+                    return midiOut.size();
+                };
+            }
+        }
+    }
+}
+
+TEST_CASE("Handing a block's steps to the arpeggiator at high densities", "[benchmark][steps]")
+{
+    const auto timing = makeTiming();
+    const auto scale = ScaleTable::fromScale(Scale(Scale::Type::Minor, 2));
+    const TrackInfo trackInfo{1, 1, ScaleMode::Off};
+
+    StepProcessor processor;
+    processor.prepare(1);
+    Arpeggiator arpeggiator;
+
+    MidiEventQueue midiOut;
+    midiOut.prepare(8192, 8192 * 3);
+
+    // The arpeggiator only takes MAX_PENDING_EVENTS a block, the rest measures the kernel
+    for (const int numSteps : {16, 256, 1024, 4096})
+    {
+        const auto steps = makeSteps(numSteps, timing, false);
+        BENCHMARK(std::to_string(numSteps) + " steps to the arpeggiator")
+        {
+            midiOut.clear();
+            processor.processSteps(steps, trackInfo, scale, timing, midiOut, &arpeggiator);
+            arpeggiator.stop(midiOut);
+            return midiOut.size();
+        };
+    }
+}
@@ -0,0 +1,115 @@
+#include "Constants.h"
+#include "core/TriggerTable.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+using Sirkus::Core::ActiveStep;
+using Sirkus::Core::StepData;
+using Sirkus::Core::TriggerBuffer;
+using Sirkus::Core::TriggerTable;
+
+namespace {
+
+constexpr int STEP_TICKS = Sirkus::Constants::STEP_16TH;
+constexpr int BLOCK_TICKS = 64; // About 512 samples at 120 BPM and 48 kHz
+
+// A pattern of numSteps sixteenths with every one enabled
+TriggerBuffer makeTriggers(const int numSteps)
+{
+    TriggerBuffer triggers;
+    triggers.cycleTicks = numSteps * STEP_TICKS;
+    triggers.stepTicks = STEP_TICKS;
+
+    StepData data;
+    data.enabled = true;
+    for (int step = 0; step < numSteps; ++step)
+        triggers.append(step * STEP_TICKS, static_cast<size_t>(step), data);
+
+    return triggers;
+}
+
+TriggerTable makeTable(const size_t numTracks, const int numSteps)
+{
+    TriggerTable table;
+    const auto triggers = makeTriggers(numSteps);
+    for (size_t slot = 0; slot < numTracks; ++slot)
+        table.addTrack(triggers);
+    return table;
+}
+
+} // namespace
+
+TEST_CASE("Collecting costs the triggers found, not the reserved capacity", "[benchmark][triggers]")
+{
+    const auto table = makeTable(1, 64);
+
+    // The same sixteen triggers, whatever the scratch was sized for
+    for (const size_t capacity : {size_t{64}, size_t{1536}, size_t{65536}})
+    {
+        std::vector<ActiveStep> out;
+        out.reserve(capacity);
+        BENCHMARK("16 triggers, capacity " + std::to_string(capacity))
+        {
+            table.collect(0, 4 * STEP_TICKS, 16 * STEP_TICKS, out);
+            return out.size();
+        };
+    }
+
+    // More triggers in the window, the same capacity
+    std::vector<ActiveStep> out;
+    out.reserve(65536);
+    for (const int numTriggers : {1, 16, 256, 4096})
+    {
+        BENCHMARK("capacity 65536, " + std::to_string(numTriggers) + " triggers")
+        {
+            table.collect(0, 0, numTriggers * STEP_TICKS, out);
+            return out.size();
+        };
+    }
+}
+
+TEST_CASE("Finding a block's triggers grows with the log of the pattern size", "[benchmark][triggers]")
+{
+    std::vector<ActiveStep> out;
+    out.reserve(1536);
+
+    // One trigger in each block-sized window, however many the pattern holds
+    for (const int numSteps : {16, 128, 1024})
+    {
+        const auto table = makeTable(1, numSteps);
+        BENCHMARK("block of a " + std::to_string(numSteps) + " step pattern")
+        {
+            table.collect(0, (numSteps / 2) * STEP_TICKS - BLOCK_TICKS / 2, BLOCK_TICKS, out);
+            return out.size();
+        };
+    }
+}
+
+TEST_CASE("A block costs the same per track however many tracks there are", "[benchmark][triggers]")
+{
+    std::vector<ActiveStep> out;
+    out.reserve(1536);
+
+    // Every slot looked up the way the engine does once per block. Divide by the track
+    // count for the cost of one track, which should stay flat
+    for (const size_t numTracks : {size_t{1}, size_t{8}, size_t{32}, size_t{64}})
+    {
+        const auto table = makeTable(numTracks, 16);
+        int blockStart = 0;
+        BENCHMARK(std::to_string(numTracks) + " tracks")
+        {
+            size_t found = 0;
+            for (size_t slot = 0; slot < table.getNumTracks(); ++slot)
+            {
+                table.collect(slot, blockStart, BLOCK_TICKS, out);
+                found += out.size();
+            }
+            blockStart += BLOCK_TICKS;
+            return found;
+        };
+    }
+}
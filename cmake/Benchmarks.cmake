@@ -0,0 +1,21 @@
+# Benchmarks, built from benchmarks/ against SharedCode with Catch2's BENCHMARK. Not run by
+# ctest: build them in Release and run the executable, "make benchmark" does both
+include(cpm)
+CPMAddPackage(
+        NAME Catch2
+        GITHUB_REPOSITORY catchorg/Catch2
+        VERSION 3.7.1
+)
+
+file(GLOB_RECURSE BenchmarkFiles CONFIGURE_DEPENDS "${CMAKE_CURRENT_SOURCE_DIR}/benchmarks/*.cpp" "${CMAKE_CURRENT_SOURCE_DIR}/benchmarks/*.h")
+source_group(TREE ${CMAKE_CURRENT_SOURCE_DIR}/benchmarks PREFIX "" FILES ${BenchmarkFiles})
+
+add_executable(Benchmarks ${BenchmarkFiles})
+target_include_directories(Benchmarks PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/src)
+
+# The plugin's definitions, so the shared code sees the same JucePlugin_ settings
+target_compile_definitions(Benchmarks PRIVATE
+        $<TARGET_PROPERTY:${PROJECT_NAME},COMPILE_DEFINITIONS>
+)
+
+target_link_libraries(Benchmarks PRIVATE SharedCode melatonin_inspector Catch2::Catch2WithMain)
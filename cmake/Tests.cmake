@@ -0,0 +1,26 @@
+# Unit tests, built from tests/ against SharedCode and run with ctest
+enable_testing()
+
+include(cpm)
+CPMAddPackage(
+        NAME Catch2
+        GITHUB_REPOSITORY catchorg/Catch2
+        VERSION 3.7.1
+)
+
+file(GLOB_RECURSE TestFiles CONFIGURE_DEPENDS "${CMAKE_CURRENT_SOURCE_DIR}/tests/*.cpp" "${CMAKE_CURRENT_SOURCE_DIR}/tests/*.h")
+source_group(TREE ${CMAKE_CURRENT_SOURCE_DIR}/tests PREFIX "" FILES ${TestFiles})
+
+add_executable(Tests ${TestFiles})
+target_include_directories(Tests PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/src)
+
+# The plugin's definitions, so the shared code sees the same JucePlugin_ settings
+target_compile_definitions(Tests PRIVATE
+        $<TARGET_PROPERTY:${PROJECT_NAME},COMPILE_DEFINITIONS>
+        JUCE_MODAL_LOOPS_PERMITTED=1          # Lets tests run the message loop
+)
+
+target_link_libraries(Tests PRIVATE SharedCode melatonin_inspector Catch2::Catch2WithMain)
+
+include(${Catch2_SOURCE_DIR}/extras/Catch.cmake)
+catch_discover_tests(Tests)
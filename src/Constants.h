@@ -7,9 +7,13 @@
 namespace Sirkus::Constants {
 
 // Timing constants
-static constexpr int MAX_STEPS = 128; // Maximum steps per pattern
-static constexpr int MAX_TRACKS = 16; // Maximum number of tracks
-static constexpr int PPQN = 960;      // Pulses Per Quarter Note
+static constexpr int MAX_STEPS = 1024;     // Maximum steps per pattern
+static constexpr int STEPS_PER_PAGE = 64;  // Steps are created a page at a time, when a step in it is first used
+static constexpr int MAX_TRACKS = 64;      // Maximum number of tracks
+static constexpr int PPQN = 960;           // Pulses Per Quarter Note
+
+// Bytes reserved up front for the MIDI buffers used on the audio thread
+static constexpr int MIDI_BUFFER_BYTES = 4096;
 
 // Base interval constants
 static constexpr int STEP_128TH = PPQN / 32;     // 30 ticks
@@ -7,7 +7,8 @@
 
 namespace Sirkus::ID {
 
-#define DECLARE_ID(name) const juce::Identifier name(#name);
+// Inline so the whole program shares one Identifier per name, and property schemas can refer to it
+#define DECLARE_ID(name) inline const juce::Identifier name(#name);
 
 DECLARE_ID(ROOT)
 DECLARE_ID(sequencer)
@@ -17,7 +18,13 @@ DECLARE_ID(pattern)
 
 namespace Sequencer {
 DECLARE_ID(swingAmount)
-}
+DECLARE_ID(keyboardChannel)
+DECLARE_ID(keyboardReferenceNote)
+DECLARE_ID(scaleFollow)
+DECLARE_ID(chaseNotes)
+DECLARE_ID(lookaheadMs)
+DECLARE_ID(muteQuantize)
+} // namespace Sequencer
 
 namespace InternalTransport {
 DECLARE_ID(bpm)
@@ -31,12 +38,23 @@ namespace Track {
 DECLARE_ID(trackId)
 DECLARE_ID(midiChannel)
 DECLARE_ID(scaleMode)
+DECLARE_ID(arpMode)
+DECLARE_ID(arpSource)
+DECLARE_ID(arpOctaves)
+DECLARE_ID(arpRate)
+DECLARE_ID(keyboardTranspose)
+DECLARE_ID(humanizeTiming)
+DECLARE_ID(humanizeVelocity)
+DECLARE_ID(humanizeSeed)
+DECLARE_ID(mute)
+DECLARE_ID(solo)
 } // namespace Track
 
 namespace Pattern {
 DECLARE_ID(length)
 DECLARE_ID(swingAmount)
 DECLARE_ID(stepInterval)
+DECLARE_ID(groove)
 } // namespace Pattern
 
 namespace Step {
@@ -49,6 +67,7 @@ DECLARE_ID(affectedBySwing)
 DECLARE_ID(triggerTick)
 DECLARE_ID(trackId)
 DECLARE_ID(noteLength)
+DECLARE_ID(stepIndex) // Where the step sits in its pattern, set once when it is created
 } // namespace Step
 
 #undef DECLARE_ID
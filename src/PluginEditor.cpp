@@ -122,13 +122,14 @@ void SirkusAudioProcessorEditor::timerCallback()
 
 void SirkusAudioProcessorEditor::updatePositionDisplay()
 {
-    auto& sequencer = processorRef.getSequencer();
-    auto& timing = sequencer.getTimingManager();
+    // A consistent snapshot of the last block the audio thread processed
+    const auto info = processorRef.getSequencer().getTimingManager().getTimingInfo();
 
-    if (const auto pos = timing.getMusicalPosition())
+    if (info.has(Sirkus::Core::TimingInfo::HAS_MUSICAL_POSITION))
     {
+        const auto& pos = info.musicalPosition;
         juce::String posText;
-        posText << "Position: Bar " << pos->bar << " | Beat " << pos->beat << " | Tick " << static_cast<int>(pos->tick);
+        posText << "Position: Bar " << pos.bar << " | Beat " << pos.beat << " | Tick " << static_cast<int>(pos.tick);
         positionLabel.setText(posText, juce::dontSendNotification);
     }
     else
@@ -136,15 +137,15 @@ void SirkusAudioProcessorEditor::updatePositionDisplay()
         positionLabel.setText("Position: --", juce::dontSendNotification);
     }
 
-    if (const auto bpm = timing.getBpm())
+    if (info.has(Sirkus::Core::TimingInfo::HAS_BPM))
     {
-        bpmLabel.setText("BPM: " + juce::String(*bpm, 1), juce::dontSendNotification);
+        bpmLabel.setText("BPM: " + juce::String(info.bpm, 1), juce::dontSendNotification);
     }
 
-    if (const auto timeSig = timing.getTimeSignature())
+    if (info.has(Sirkus::Core::TimingInfo::HAS_TIME_SIGNATURE))
     {
         timeSignatureLabel.setText(
-            "Time Sig: " + juce::String(timeSig->first) + "/" + juce::String(timeSig->second),
+            "Time Sig: " + juce::String(info.timeSigNumerator) + "/" + juce::String(info.timeSigDenominator),
             juce::dontSendNotification);
     }
 }
@@ -157,22 +158,23 @@ void SirkusAudioProcessorEditor::updateTransportDisplay()
 void SirkusAudioProcessorEditor::updatePlaybackPosition()
 {
     auto& sequencer = processorRef.getSequencer();
-    const auto& timing = sequencer.getTimingManager();
+    const auto info = sequencer.getTimingManager().getTimingInfo();
 
     // Clear all step triggers first
     trackPanel.clearAllTriggers();
 
     // Early return if not playing
-    if (!timing.isPlaying())
+    if (!info.isPlaying)
         return;
 
     // Early return if no position available
-    const auto pos = timing.getMusicalPosition();
-    if (!pos)
+    if (!info.has(Sirkus::Core::TimingInfo::HAS_MUSICAL_POSITION))
         return;
 
+    const auto& pos = info.musicalPosition;
+
     // Calculate total ticks once
-    const int totalTicks = (((pos->bar - 1) * 4 + (pos->beat - 1)) * Sirkus::Core::PPQN) + static_cast<int>(pos->tick);
+    const int totalTicks = (((pos.bar - 1) * 4 + (pos.beat - 1)) * Sirkus::Core::PPQN) + static_cast<int>(pos.tick);
 
     // Process each track
     for (size_t trackIndex = 0; trackIndex < sequencer.getTrackCount(); ++trackIndex)
@@ -240,6 +242,9 @@ void SirkusAudioProcessorEditor::updateSelectedSteps()
         // Use the first selected step to initialize the controls
         auto [trackIndex, stepIndex] = selectedSteps[0];
 
+        // MIDI thru follows the track being edited
+        sequencer.setSelectedTrack(static_cast<uint32_t>(trackIndex));
+
         auto& pattern = sequencer.getCurrentPatternForTrack(static_cast<uint32_t>(trackIndex));
 
         const auto& step = pattern.getStep(static_cast<size_t>(stepIndex));
@@ -257,6 +262,7 @@ void SirkusAudioProcessorEditor::trackMidiChannelChanged(
 {
     SIRKUS_UNUSED(panel); // Will be used for future panel-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change MIDI channel");
     auto& sequencer = processorRef.getSequencer();
     auto& track = sequencer.getTrack(static_cast<uint32_t>(trackIndex));
     track.setMidiChannel(static_cast<uint8_t>(newChannel));
@@ -269,6 +275,7 @@ void SirkusAudioProcessorEditor::stepStateChanged(
 {
     SIRKUS_UNUSED(panel); // Will be used for future panel-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Toggle step");
     auto& sequencer = processorRef.getSequencer();
     auto& pattern = sequencer.getCurrentPatternForTrack(static_cast<uint32_t>(trackIndex));
 
@@ -326,6 +333,7 @@ void SirkusAudioProcessorEditor::patternLengthChanged(
 {
     SIRKUS_UNUSED(panel); // Will be used for future panel-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change pattern length");
     auto& sequencer = processorRef.getSequencer();
     auto& pattern = sequencer.getCurrentPatternForTrack(static_cast<uint32_t>(trackIndex));
     pattern.setLength(static_cast<size_t>(newLength));
@@ -336,6 +344,7 @@ void SirkusAudioProcessorEditor::noteValueChanged(Sirkus::UI::StepControls* cont
 {
     SIRKUS_UNUSED(controls); // Will be used for control-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change note");
     auto& sequencer = processorRef.getSequencer();
 
     // Update note value for all selected steps
@@ -351,6 +360,7 @@ void SirkusAudioProcessorEditor::velocityChanged(Sirkus::UI::StepControls* contr
 {
     SIRKUS_UNUSED(controls); // Will be used for control-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change velocity");
     auto& sequencer = processorRef.getSequencer();
     const auto selectedSteps = trackPanel.getAllSelectedSteps();
 
@@ -368,6 +378,7 @@ void SirkusAudioProcessorEditor::noteLengthChanged(
 {
     SIRKUS_UNUSED(controls); // Will be used for control-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change note length");
     auto& sequencer = processorRef.getSequencer();
     const auto selectedSteps = trackPanel.getAllSelectedSteps();
 
@@ -379,6 +390,20 @@ void SirkusAudioProcessorEditor::noteLengthChanged(
     }
 }
 
+void SirkusAudioProcessorEditor::editGestureStarted(Sirkus::UI::StepControls* controls)
+{
+    SIRKUS_UNUSED(controls);
+
+    // A whole slider drag undoes in one go, repeated edits to a step are coalesced
+    processorRef.getUndoHistory().beginGesture("Edit steps");
+}
+
+void SirkusAudioProcessorEditor::editGestureEnded(Sirkus::UI::StepControls* controls)
+{
+    SIRKUS_UNUSED(controls);
+    processorRef.getUndoHistory().endGesture();
+}
+
 // GlobalControls::Listener implementation
 void SirkusAudioProcessorEditor::timeSignatureChanged(
     Sirkus::UI::GlobalControls* controls,
@@ -399,6 +424,7 @@ void SirkusAudioProcessorEditor::stepIntervalChanged(
 {
     SIRKUS_UNUSED(controls); // Will be used for control-specific operations
 
+    processorRef.getUndoHistory().beginEdit("Change step interval");
     auto& sequencer = processorRef.getSequencer();
 
     // Update step interval for all tracks' patterns
@@ -58,6 +58,8 @@ private:
     void noteValueChanged(Sirkus::UI::StepControls* controls, int newValue) override;
     void velocityChanged(Sirkus::UI::StepControls* controls, int newValue) override;
     void noteLengthChanged(Sirkus::UI::StepControls* controls, Sirkus::Core::TimeDivision newLength) override;
+    void editGestureStarted(Sirkus::UI::StepControls* controls) override;
+    void editGestureEnded(Sirkus::UI::StepControls* controls) override;
 
     // GlobalControls::Listener implementation
     void timeSignatureChanged(Sirkus::UI::GlobalControls* controls, int numerator, int denominator) override;
@@ -2,26 +2,40 @@
 
 #include "Constants.h"
 #include "PluginEditor.h"
+#include "core/MidiBufferUtils.h"
 
 
 SirkusAudioProcessor::SirkusAudioProcessor()
     : AudioProcessor(BusesProperties())
       , pluginState(juce::Identifier("SirkusPluginState"))
-      , undoManager(50)
       , sequencer(pluginState, undoManager)
+      , parameters(*this, sequencer, undoManager)
 {
     while (sequencer.getTrackCount() < Sirkus::UI::TrackPanelConfig::numTracks)
     {
         sequencer.createTrack();
     }
+
+    // Building the initial tracks isn't something to undo
+    undoManager.clearUndoHistory();
+
+    sequencer.setParameters(&parameters);
+
+    // Lookahead changes, undo and redo included, reach the host as latency
+    sequencer.onLatencyChanged = [this](const int latencySamples) { setLatencySamples(latencySamples); };
 }
 
 SirkusAudioProcessor::~SirkusAudioProcessor() = default;
 
 void SirkusAudioProcessor::prepareToPlay(const double sampleRate, const int samplesPerBlock)
 {
-    SIRKUS_UNUSED(samplesPerBlock);
-    sequencer.prepare(sampleRate);
+    sequencer.prepare(sampleRate, samplesPerBlock);
+    setLatencySamples(sequencer.getLatencySamples());
+
+    // The editor's copy of the output gets room for a full block up front
+    const auto bytes = static_cast<size_t>(sequencer.getOutputBufferBytes());
+    latestMidiMessages.ensureSize(bytes);
+    midiBufferBytes.store(bytes);
 }
 
 void SirkusAudioProcessor::releaseResources()
@@ -33,6 +47,11 @@ void SirkusAudioProcessor::setHostSyncEnabled(const bool enabled)
     sequencer.getTimingManager().setHostSyncEnabled(enabled);
 }
 
+void SirkusAudioProcessor::setLookaheadMs(const double ms)
+{
+    sequencer.setLookaheadMs(ms);
+}
+
 [[nodiscard]]
 bool SirkusAudioProcessor::isHostSyncEnabled()
 {
@@ -44,22 +63,35 @@ void SirkusAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     juce::ScopedNoDenormals noDenormals;
     const auto numSamples = buffer.getNumSamples();
 
-    midiMessages.clear();
     if (const auto* playHead = getPlayHead(); playHead != nullptr)
     {
+        // The sequencer reads the host's input and replaces it with the block's output
         sequencer.processBlock(playHead, numSamples, midiMessages);
 
-        // Store MIDI messages for the editor
+        // Store MIDI messages for the editor. The output is already in order, so it goes into
+        // the reserved buffer in one append, where assigning one MidiBuffer to another reallocates
         const juce::ScopedLock sl(midiBufferLock);
-        latestMidiMessages = midiMessages;
+        latestMidiMessages.clear();
+        Sirkus::Core::MidiBufferUtils::appendAll(latestMidiMessages, midiMessages);
+    }
+    else
+    {
+        midiMessages.clear();
     }
 }
 
 juce::MidiBuffer SirkusAudioProcessor::getAndClearLatestMidiMessages()
 {
-    const juce::ScopedLock sl(midiBufferLock);
-    juce::MidiBuffer messages;
-    messages.swapWith(latestMidiMessages);
+    // The audio thread takes the lock every block, so only a swap happens under it. The
+    // buffer it gets back is empty and reserved here first, off the audio thread
+    editorMidiMessages.ensureSize(midiBufferBytes.load());
+    {
+        const juce::ScopedLock sl(midiBufferLock);
+        latestMidiMessages.swapWith(editorMidiMessages);
+    }
+
+    juce::MidiBuffer messages(editorMidiMessages);
+    editorMidiMessages.clear();
     return messages;
 }
 
@@ -160,6 +192,11 @@ Sirkus::Core::Sequencer& SirkusAudioProcessor::getSequencer()
     return sequencer;
 }
 
+Sirkus::Core::UndoHistory& SirkusAudioProcessor::getUndoHistory()
+{
+    return undoManager;
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool SirkusAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
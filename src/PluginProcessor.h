@@ -8,10 +8,14 @@
 
 #pragma once
 
+#include "core/Parameters.h"
 #include "core/Sequencer.h"
+#include "core/UndoHistory.h"
 
 #include "JuceHeader.h"
 
+#include <atomic>
+
 
 //==============================================================================
 /**
@@ -68,15 +72,24 @@ public:
     // Host sync control
     void setHostSyncEnabled(const bool enabled);
 
+    // Lookahead, reported to the host as latency
+    void setLookaheadMs(double ms);
+
     // Direct access to sequencer
     Sirkus::Core::Sequencer& getSequencer();
 
+    // Edits from the UI group themselves into transactions here
+    Sirkus::Core::UndoHistory& getUndoHistory();
+
 private:
     juce::MidiBuffer latestMidiMessages;
+    juce::MidiBuffer editorMidiMessages; // Message thread only, swapped with latestMidiMessages
     juce::CriticalSection midiBufferLock;
+    std::atomic<size_t> midiBufferBytes{0};
     juce::ValueTree pluginState;
-    juce::UndoManager undoManager;
+    Sirkus::Core::UndoHistory undoManager;
     Sirkus::Core::Sequencer sequencer;
+    Sirkus::Core::Parameters parameters;
 
 public:
     // Get the latest MIDI messages and clear the buffer
@@ -0,0 +1,346 @@
+#include "Arpeggiator.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+Arpeggiator::Arpeggiator() = default;
+
+void Arpeggiator::addNote(const int tick, const uint8_t note, const uint8_t velocity, const int releaseTick)
+{
+    if (numPending >= MAX_PENDING_EVENTS)
+        return; // Drop rather than allocate, a full queue means the block is already saturated
+
+    // Keep the queue ordered by tick so it can be consumed from the front
+    size_t insertAt = numPending;
+    while (insertAt > 0 && pending[insertAt - 1].tick > tick)
+    {
+        pending[insertAt] = pending[insertAt - 1];
+        --insertAt;
+    }
+
+    pending[insertAt] = PendingEvent{tick, releaseTick, note, velocity};
+    ++numPending;
+}
+
+void Arpeggiator::process(
+    const ArpSettings& settings,
+    const uint8_t midiChannel,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut)
+{
+    if (settings.source != lastSettings.source)
+    {
+        // Notes held from the previous source will never see their release
+        numHeld = 0;
+    }
+
+    if (settings.mode != lastSettings.mode || settings.octaves != lastSettings.octaves ||
+        settings.source != lastSettings.source)
+    {
+        sequenceDirty = true;
+    }
+
+    lastSettings = settings;
+
+    if (isIdle() || timing.getNumTicks() <= 0)
+        return;
+
+    const auto startTick = static_cast<int>(timing.startTick);
+    const auto endTick = static_cast<int>(timing.endTick);
+    const int rate = std::max(1, stepIntervalToTicks(settings.rate));
+    const int gateTicks = std::max(1, rate / 2);
+
+    // First grid position at or after startTick (floor division so negative ticks work)
+    const int firstGrid = startTick >= 0 ? (startTick + rate - 1) / rate : -((-startTick) / rate);
+
+    for (int gridTick = firstGrid * rate; gridTick < endTick; gridTick += rate)
+    {
+        applyPendingEvents(gridTick);
+        releaseExpiredNotes(gridTick);
+        emitNoteOffs(gridTick, timing, midiOut);
+
+        if (sequenceDirty)
+            rebuildSequence(settings);
+
+        if (sequenceLength == 0)
+        {
+            // Nothing held, the next chord starts from the beginning
+            position = 0;
+            direction = 1;
+            continue;
+        }
+
+        const size_t index = nextSequenceIndex(settings.mode);
+        startNote(
+            midiChannel,
+            sequence[index],
+            sequenceVelocities[index],
+            gridTick + gateTicks,
+            timing.tickToSampleOffset(gridTick),
+            midiOut);
+    }
+
+    // Catch up with everything else that happens before the end of the block
+    applyPendingEvents(endTick - 1);
+    releaseExpiredNotes(endTick - 1);
+    emitNoteOffs(endTick - 1, timing, midiOut);
+}
+
+void Arpeggiator::stop(MidiEventQueue& midiOut, const int sampleOffset)
+{
+    for (size_t i = 0; i < numPlaying; ++i)
+    {
+        midiOut.addEvent(juce::MidiMessage::noteOff(playing[i].channel, playing[i].note), sampleOffset);
+    }
+
+    numPlaying = 0;
+    numPending = 0;
+    numHeld = 0;
+    sequenceLength = 0;
+    sequenceDirty = true;
+    position = 0;
+    direction = 1;
+}
+
+void Arpeggiator::applyPendingEvents(const int upToTick)
+{
+    size_t consumed = 0;
+    while (consumed < numPending && pending[consumed].tick <= upToTick)
+    {
+        const auto& event = pending[consumed];
+        if (event.velocity > 0)
+            holdNote(event.note, event.velocity, event.releaseTick);
+        else
+            releaseNote(event.note);
+        ++consumed;
+    }
+
+    if (consumed == 0)
+        return;
+
+    std::move(
+        pending.begin() + static_cast<std::ptrdiff_t>(consumed),
+        pending.begin() + static_cast<std::ptrdiff_t>(numPending),
+        pending.begin());
+    numPending -= consumed;
+}
+
+void Arpeggiator::releaseExpiredNotes(const int atTick)
+{
+    for (size_t i = 0; i < numHeld;)
+    {
+        if (held[i].releaseTick <= atTick)
+        {
+            held[i] = held[numHeld - 1];
+            --numHeld;
+            sequenceDirty = true;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void Arpeggiator::holdNote(const uint8_t note, const uint8_t velocity, const int releaseTick)
+{
+    for (size_t i = 0; i < numHeld; ++i)
+    {
+        if (held[i].note == note)
+        {
+            // Retriggered while held, keep the later release
+            held[i].velocity = velocity;
+            held[i].releaseTick = std::max(held[i].releaseTick, releaseTick);
+            sequenceDirty = true;
+            return;
+        }
+    }
+
+    if (numHeld >= MAX_HELD_NOTES)
+        return;
+
+    held[numHeld++] = HeldNote{releaseTick, nextOrder++, note, velocity};
+    sequenceDirty = true;
+}
+
+void Arpeggiator::releaseNote(const uint8_t note)
+{
+    for (size_t i = 0; i < numHeld; ++i)
+    {
+        if (held[i].note == note)
+        {
+            held[i] = held[numHeld - 1];
+            --numHeld;
+            sequenceDirty = true;
+            return;
+        }
+    }
+}
+
+void Arpeggiator::rebuildSequence(const ArpSettings& settings)
+{
+    sequenceDirty = false;
+    sequenceLength = 0;
+
+    if (numHeld == 0)
+        return;
+
+    std::array<HeldNote, MAX_HELD_NOTES> ordered{};
+    std::copy_n(held.begin(), numHeld, ordered.begin());
+    const auto orderedEnd = ordered.begin() + static_cast<std::ptrdiff_t>(numHeld);
+
+    if (settings.mode == ArpMode::AsPlayed)
+    {
+        std::sort(ordered.begin(), orderedEnd, [](const auto& a, const auto& b) { return a.order < b.order; });
+    }
+    else
+    {
+        std::sort(ordered.begin(), orderedEnd, [](const auto& a, const auto& b) { return a.note < b.note; });
+    }
+
+    const size_t octaves = std::clamp<size_t>(settings.octaves, 1, MAX_OCTAVES);
+    for (size_t octave = 0; octave < octaves; ++octave)
+    {
+        for (size_t i = 0; i < numHeld; ++i)
+        {
+            const int note = ordered[i].note + static_cast<int>(octave) * 12;
+            if (note > 127)
+                continue;
+
+            sequence[sequenceLength] = static_cast<uint8_t>(note);
+            sequenceVelocities[sequenceLength] = ordered[i].velocity;
+            ++sequenceLength;
+        }
+    }
+
+    if (settings.mode == ArpMode::Down)
+    {
+        std::reverse(sequence.begin(), sequence.begin() + static_cast<std::ptrdiff_t>(sequenceLength));
+        std::reverse(
+            sequenceVelocities.begin(),
+            sequenceVelocities.begin() + static_cast<std::ptrdiff_t>(sequenceLength));
+    }
+}
+
+size_t Arpeggiator::nextSequenceIndex(const ArpMode mode)
+{
+    const size_t length = sequenceLength;
+
+    switch (mode)
+    {
+        case ArpMode::Random:
+            return static_cast<size_t>(random.nextInt(static_cast<int>(length)));
+
+        case ArpMode::UpDown:
+        {
+            if (length == 1)
+                return 0;
+
+            // Bounce between the ends without repeating them
+            const size_t index = std::min(position, length - 1);
+            if (direction > 0)
+            {
+                if (index + 1 >= length)
+                {
+                    direction = -1;
+                    position = index - 1;
+                }
+                else
+                {
+                    position = index + 1;
+                }
+            }
+            else
+            {
+                if (index == 0)
+                {
+                    direction = 1;
+                    position = 1;
+                }
+                else
+                {
+                    position = index - 1;
+                }
+            }
+            return index;
+        }
+
+        case ArpMode::Off:
+        case ArpMode::Up:
+        case ArpMode::Down:
+        case ArpMode::AsPlayed:
+        default:
+        {
+            const size_t index = position % length;
+            position = index + 1;
+            return index;
+        }
+    }
+}
+
+void Arpeggiator::emitNoteOffs(
+    const int upToTick,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut)
+{
+    for (size_t i = 0; i < numPlaying;)
+    {
+        if (playing[i].offTick <= upToTick)
+        {
+            midiOut.addEvent(
+                juce::MidiMessage::noteOff(playing[i].channel, playing[i].note),
+                timing.tickToSampleOffset(playing[i].offTick));
+            playing[i] = playing[numPlaying - 1];
+            --numPlaying;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+void Arpeggiator::startNote(
+    const uint8_t channel,
+    const uint8_t note,
+    const uint8_t velocity,
+    const int offTick,
+    const int sampleOffset,
+    MidiEventQueue& midiOut)
+{
+    // Never stack the same note, and make room by cutting the note that ends first
+    size_t slot = numPlaying;
+    for (size_t i = 0; i < numPlaying; ++i)
+    {
+        if (playing[i].channel == channel && playing[i].note == note)
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    if (slot == numPlaying && numPlaying >= MAX_PLAYING_NOTES)
+    {
+        slot = 0;
+        for (size_t i = 1; i < numPlaying; ++i)
+        {
+            if (playing[i].offTick < playing[slot].offTick)
+                slot = i;
+        }
+    }
+
+    if (slot < numPlaying)
+    {
+        midiOut.addEvent(juce::MidiMessage::noteOff(playing[slot].channel, playing[slot].note), sampleOffset);
+    }
+    else
+    {
+        ++numPlaying;
+    }
+
+    midiOut.addEvent(juce::MidiMessage::noteOn(channel, note, velocity), sampleOffset);
+    playing[slot] = PlayingNote{offTick, channel, note};
+}
+
+} // namespace Sirkus::Core
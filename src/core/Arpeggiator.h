@@ -0,0 +1,121 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "BlockTiming.h"
+#include "MidiEventQueue.h"
+#include "Types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Sirkus::Core {
+
+// Arpeggiator configuration read from the owning track once per block
+struct ArpSettings
+{
+    ArpMode mode{ArpMode::Off};
+    ArpSource source{ArpSource::Steps};
+    uint8_t octaves{1};
+    TimeDivision rate{TimeDivision::SixteenthNote};
+};
+
+/*
+Per-track arpeggiator stage that runs after StepProcessor.
+
+Notes enter through addNote(), either from the track's own steps (with the tick the
+step releases at) or from incoming MIDI (held until a matching release). All state
+lives in fixed-size arrays so process() never allocates, and the notes the
+arpeggiator starts are remembered until their note-off has been emitted, even when
+that happens several blocks later.
+*/
+class Arpeggiator
+{
+public:
+    static constexpr size_t MAX_HELD_NOTES = 16;
+    static constexpr size_t MAX_OCTAVES = 4;
+    static constexpr size_t MAX_PENDING_EVENTS = 64;
+    static constexpr size_t MAX_PLAYING_NOTES = 16;
+    static constexpr int NO_RELEASE = std::numeric_limits<int>::max();
+
+    Arpeggiator();
+
+    // Queue a note for the tick it starts at. A velocity of 0 releases a held note,
+    // releaseTick releases it automatically (NO_RELEASE keeps it until released)
+    void addNote(int tick, uint8_t note, uint8_t velocity, int releaseTick = NO_RELEASE);
+
+    // Generate arpeggiated notes for the block's tick window
+    void process(
+        const ArpSettings& settings,
+        uint8_t midiChannel,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut);
+
+    // Send note-offs for everything still sounding and forget all held notes
+    void stop(MidiEventQueue& midiOut, int sampleOffset = 0);
+
+    [[nodiscard]] bool isIdle() const
+    {
+        return numHeld == 0 && numPending == 0 && numPlaying == 0;
+    }
+
+private:
+    struct PendingEvent
+    {
+        int tick;
+        int releaseTick;
+        uint8_t note;
+        uint8_t velocity;
+    };
+
+    struct HeldNote
+    {
+        int releaseTick;
+        uint32_t order; // Arrival order, used by AsPlayed
+        uint8_t note;
+        uint8_t velocity;
+    };
+
+    struct PlayingNote
+    {
+        int offTick;
+        uint8_t channel;
+        uint8_t note;
+    };
+
+    void applyPendingEvents(int upToTick);
+    void releaseExpiredNotes(int atTick);
+    void holdNote(uint8_t note, uint8_t velocity, int releaseTick);
+    void releaseNote(uint8_t note);
+    void rebuildSequence(const ArpSettings& settings);
+    size_t nextSequenceIndex(ArpMode mode);
+    void emitNoteOffs(int upToTick, const BlockTiming& timing, MidiEventQueue& midiOut);
+    void startNote(uint8_t channel, uint8_t note, uint8_t velocity, int offTick, int sampleOffset, MidiEventQueue& midiOut);
+
+    std::array<PendingEvent, MAX_PENDING_EVENTS> pending{};
+    size_t numPending{0};
+
+    std::array<HeldNote, MAX_HELD_NOTES> held{};
+    size_t numHeld{0};
+    uint32_t nextOrder{0};
+
+    // Held notes expanded over the octave range in play order
+    std::array<uint8_t, MAX_HELD_NOTES * MAX_OCTAVES> sequence{};
+    std::array<uint8_t, MAX_HELD_NOTES * MAX_OCTAVES> sequenceVelocities{};
+    size_t sequenceLength{0};
+    bool sequenceDirty{true};
+    ArpSettings lastSettings;
+
+    size_t position{0};
+    int direction{1};
+
+    std::array<PlayingNote, MAX_PLAYING_NOTES> playing{};
+    size_t numPlaying{0};
+
+    juce::Random random;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Arpeggiator)
+};
+
+} // namespace Sirkus::Core
@@ -0,0 +1,146 @@
+#include "BlockTiming.h"
+
+#include "../Constants.h"
+#include "TempoMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Sirkus::Core {
+
+int64_t mulDivFloor(const int64_t a, const int64_t b, const int64_t c)
+{
+    const __int128 product = static_cast<__int128>(a) * b;
+    __int128 quotient = product / c;
+    if (product % c != 0 && product < 0)
+        --quotient;
+    return static_cast<int64_t>(quotient);
+}
+
+int64_t mulDivCeil(const int64_t a, const int64_t b, const int64_t c)
+{
+    const __int128 product = static_cast<__int128>(a) * b;
+    __int128 quotient = product / c;
+    if (product % c != 0 && product > 0)
+        ++quotient;
+    return static_cast<int64_t>(quotient);
+}
+
+BlockTiming BlockTiming::fromRate(
+    const int64_t anchorTick,
+    const int64_t anchorSample,
+    const int64_t rateTicks,
+    const int64_t rateSamples,
+    const int numSamples)
+{
+    BlockTiming timing;
+    timing.anchorTick = anchorTick;
+    timing.anchorSample = anchorSample;
+    timing.rateTicks = std::max<int64_t>(rateTicks, 1);
+    timing.rateSamples = std::max<int64_t>(rateSamples, 1);
+    timing.numSamples = std::max(numSamples, 0);
+
+    // A tick sounds on the first whole sample at or after its exact position, so the block
+    // owns the ticks after the one that sounded before it, through the one its last sample plays
+    timing.startTick = timing.tickAtSample(-1) + 1;
+    timing.endTick = timing.tickAtSample(timing.numSamples - 1) + 1;
+    return timing;
+}
+
+BlockTiming BlockTiming::fromTempoMap(const TempoMap& tempoMap, const double mapSample, const int numSamples)
+{
+    BlockTiming timing;
+    timing.tempoMap = &tempoMap;
+    timing.mapSample = mapSample;
+    timing.numSamples = std::max(numSamples, 0);
+    timing.startTick = timing.tickAtSample(-1) + 1;
+    timing.endTick = timing.tickAtSample(timing.numSamples - 1) + 1;
+    return timing;
+}
+
+BlockTiming BlockTiming::fromPpq(const double ppqPosition, const double bpm, const double sampleRate, const int numSamples)
+{
+    int64_t rateTicks = 1;
+    int64_t rateSamples = 1;
+    tempoToRate(bpm, sampleRate, rateTicks, rateSamples);
+
+    // Anchor on the last whole tick, placed where it fell before the block started
+    const double exactTick = ppqPosition * Constants::PPQN;
+    const double wholeTick = std::floor(exactTick);
+    const auto samplesSinceTick = static_cast<int64_t>(
+        std::llround((exactTick - wholeTick) * static_cast<double>(rateSamples) / static_cast<double>(rateTicks)));
+
+    return fromRate(static_cast<int64_t>(wholeTick), -samplesSinceTick, rateTicks, rateSamples, numSamples);
+}
+
+BlockTiming BlockTiming::delayedBy(const int64_t delaySamples) const
+{
+    if (tempoMap != nullptr)
+        return fromTempoMap(*tempoMap, mapSample - static_cast<double>(delaySamples), numSamples);
+
+    return fromRate(anchorTick, anchorSample + delaySamples, rateTicks, rateSamples, numSamples);
+}
+
+void BlockTiming::tempoToRate(const double bpm, const double sampleRate, int64_t& rateTicks, int64_t& rateSamples)
+{
+    const int64_t scaledBpm = std::max<int64_t>(std::llround(bpm * TEMPO_SCALE), 1);
+    const int64_t wholeSampleRate = std::max<int64_t>(std::llround(sampleRate), 1);
+
+    // ticks/sample = bpm * PPQN / (60 * sampleRate)
+    rateTicks = scaledBpm * Constants::PPQN;
+    rateSamples = 60 * TEMPO_SCALE * wholeSampleRate;
+}
+
+int64_t BlockTiming::tickAtSample(const int64_t sampleOffset) const
+{
+    if (tempoMap != nullptr)
+        return static_cast<int64_t>(std::floor(mapTickAtSample(sampleOffset)));
+
+    return anchorTick + mulDivFloor(sampleOffset - anchorSample, rateTicks, rateSamples);
+}
+
+int64_t BlockTiming::firstTickAtOrAfter(const int64_t sampleOffset) const
+{
+    if (tempoMap != nullptr)
+        return static_cast<int64_t>(std::ceil(mapTickAtSample(sampleOffset)));
+
+    return anchorTick + mulDivCeil(sampleOffset - anchorSample, rateTicks, rateSamples);
+}
+
+int64_t BlockTiming::sampleAtTick(const int64_t tick) const
+{
+    if (tempoMap != nullptr)
+    {
+        const double sample = tempoMap->tickToSample(static_cast<double>(tick), segmentHint) - mapSample;
+        return static_cast<int64_t>(std::ceil(sample));
+    }
+
+    return anchorSample + mulDivCeil(tick - anchorTick, rateSamples, rateTicks);
+}
+
+int BlockTiming::tickToSampleOffset(const int64_t tick) const
+{
+    if (numSamples <= 0)
+        return 0;
+
+    return static_cast<int>(std::clamp<int64_t>(sampleAtTick(tick), 0, numSamples - 1));
+}
+
+double BlockTiming::mapTickAtSample(const int64_t sampleOffset) const
+{
+    return tempoMap->sampleToTick(mapSample + static_cast<double>(sampleOffset), segmentHint);
+}
+
+double BlockTiming::getSamplesPerTick() const
+{
+    if (tempoMap != nullptr)
+    {
+        // Tempo at the start of the block
+        const auto tick = static_cast<double>(startTick);
+        return tempoMap->tickToSample(tick + 1.0, segmentHint) - tempoMap->tickToSample(tick, segmentHint);
+    }
+
+    return static_cast<double>(rateSamples) / static_cast<double>(rateTicks);
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+class TempoMap;
+
+// floor(a * b / c) and ceil(a * b / c) for c > 0. The product is formed in 128 bits so
+// sample counts from hours-long runs can be scaled without overflowing
+int64_t mulDivFloor(int64_t a, int64_t b, int64_t c);
+int64_t mulDivCeil(int64_t a, int64_t b, int64_t c);
+
+/*
+Where a block sits on the tick timeline.
+
+Tick anchorTick falls exactly on sample anchorSample (counted from the block's first
+sample), and from there rateTicks ticks pass every rateSamples samples. Tempo is held
+to a thousandth of a BPM so the rate is an exact ratio. Converting between ticks and
+samples is then exact integer arithmetic, and consecutive blocks of an internally
+clocked transport tile the timeline without gaps or overlaps at any buffer size.
+
+When the tempo changes or ramps, the block follows a TempoMap instead: mapSample is
+where its first sample sits on the map, and conversions go through the map's
+closed-form segments.
+
+A tick sounds on the first whole sample at or after its exact position. The block owns
+the whole ticks [startTick, endTick), the ones that sound on one of its samples.
+*/
+struct BlockTiming
+{
+    static constexpr int64_t TEMPO_SCALE = 1000; // BPM resolution
+
+    int64_t anchorTick{0};
+    int64_t anchorSample{0};
+    int64_t rateTicks{1};
+    int64_t rateSamples{1};
+    int numSamples{0};
+
+    int64_t startTick{0};
+    int64_t endTick{0};
+
+    const TempoMap* tempoMap{nullptr};
+    double mapSample{0.0};
+    mutable size_t segmentHint{0}; // Consecutive lookups usually stay in one segment
+
+    static BlockTiming fromRate(
+        int64_t anchorTick,
+        int64_t anchorSample,
+        int64_t rateTicks,
+        int64_t rateSamples,
+        int numSamples);
+
+    static BlockTiming fromTempoMap(const TempoMap& tempoMap, double mapSample, int numSamples);
+
+    // For positions that only arrive as floating point, from a host or external clock
+    static BlockTiming fromPpq(double ppqPosition, double bpm, double sampleRate, int numSamples);
+
+    // The same block on a timeline running delaySamples behind this one, so every tick
+    // lands delaySamples later. Used to render ahead of a latency-compensating host
+    [[nodiscard]] BlockTiming delayedBy(int64_t delaySamples) const;
+
+    // Exact tick rate for a tempo: rateTicks ticks every rateSamples samples
+    static void tempoToRate(double bpm, double sampleRate, int64_t& rateTicks, int64_t& rateSamples);
+
+    // Last whole tick at or before a sample, and first whole tick at or after it
+    [[nodiscard]] int64_t tickAtSample(int64_t sampleOffset) const;
+    [[nodiscard]] int64_t firstTickAtOrAfter(int64_t sampleOffset) const;
+
+    // First sample at or after a tick, relative to the block start. May lie outside the block
+    [[nodiscard]] int64_t sampleAtTick(int64_t tick) const;
+
+    // Sample offset of a tick, clamped into the block
+    [[nodiscard]] int tickToSampleOffset(int64_t tick) const;
+
+    [[nodiscard]] bool contains(const int64_t tick) const { return tick >= startTick && tick < endTick; }
+    [[nodiscard]] int64_t getNumTicks() const { return endTick - startTick; }
+    [[nodiscard]] double getSamplesPerTick() const;
+
+private:
+    [[nodiscard]] double mapTickAtSample(int64_t sampleOffset) const;
+};
+
+} // namespace Sirkus::Core
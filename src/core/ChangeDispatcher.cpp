@@ -0,0 +1,161 @@
+#include "ChangeDispatcher.h"
+
+#include "../Identifiers.h"
+#include "Pattern.h"
+#include "Sequencer.h"
+#include "Step.h"
+#include "Track.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+namespace {
+int getSchemaIndex(const ChangeEvent::Node node, const juce::Identifier& property)
+{
+    switch (node)
+    {
+        case ChangeEvent::Node::Sequencer:
+            return Sequencer::Schema::indexOf(property);
+        case ChangeEvent::Node::Track:
+            return Track::Schema::indexOf(property);
+        case ChangeEvent::Node::Pattern:
+            return Pattern::Schema::indexOf(property);
+        case ChangeEvent::Node::Step:
+            return Step::Schema::indexOf(property);
+    }
+    return -1;
+}
+
+uint32_t getTrackId(const juce::ValueTree& trackTree)
+{
+    return VariantConverter<uint32_t>::fromVar(trackTree.getProperty(ID::Track::trackId));
+}
+} // namespace
+
+ChangeDispatcher::ChangeDispatcher(juce::ValueTree sequencerState)
+    : root(std::move(sequencerState))
+{
+    root.addListener(this);
+}
+
+ChangeDispatcher::~ChangeDispatcher()
+{
+    cancelPendingUpdate();
+    root.removeListener(this);
+}
+
+void ChangeDispatcher::addSubscriber(Subscriber* subscriber)
+{
+    subscribers.add(subscriber);
+}
+
+void ChangeDispatcher::removeSubscriber(Subscriber* subscriber)
+{
+    subscribers.remove(subscriber);
+}
+
+void ChangeDispatcher::dispatchPendingChanges()
+{
+    cancelPendingUpdate();
+    handleAsyncUpdate();
+}
+
+void ChangeDispatcher::valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property)
+{
+    enqueue(tree, &property);
+}
+
+void ChangeDispatcher::valueTreeChildAdded(juce::ValueTree& parent, juce::ValueTree& child)
+{
+    juce::ignoreUnused(child);
+    enqueue(parent, nullptr);
+}
+
+void ChangeDispatcher::valueTreeChildRemoved(juce::ValueTree& parent, juce::ValueTree& child, const int index)
+{
+    juce::ignoreUnused(child, index);
+    enqueue(parent, nullptr);
+}
+
+void ChangeDispatcher::valueTreeChildOrderChanged(juce::ValueTree& parent, const int oldIndex, const int newIndex)
+{
+    juce::ignoreUnused(oldIndex, newIndex);
+    enqueue(parent, nullptr);
+}
+
+bool ChangeDispatcher::locate(const juce::ValueTree& tree, ChangeEvent& change) const
+{
+    if (tree == root)
+    {
+        change.node = ChangeEvent::Node::Sequencer;
+        return true;
+    }
+
+    if (tree.hasType(ID::track))
+    {
+        change.node = ChangeEvent::Node::Track;
+        change.trackId = getTrackId(tree);
+        return true;
+    }
+
+    if (tree.hasType(ID::pattern))
+    {
+        const auto trackTree = tree.getParent();
+        change.node = ChangeEvent::Node::Pattern;
+        change.trackId = getTrackId(trackTree);
+        change.pattern = static_cast<uint16_t>(std::max(0, trackTree.indexOf(tree)));
+        return true;
+    }
+
+    if (tree.hasType(ID::step))
+    {
+        const auto patternTree = tree.getParent();
+        const auto trackTree = patternTree.getParent();
+        change.node = ChangeEvent::Node::Step;
+        change.trackId = getTrackId(trackTree);
+        change.pattern = static_cast<uint16_t>(std::max(0, trackTree.indexOf(patternTree)));
+        change.step = static_cast<uint16_t>(std::max(0, static_cast<int>(tree.getProperty(ID::Step::stepIndex, 0))));
+        return true;
+    }
+
+    return false;
+}
+
+void ChangeDispatcher::enqueue(const juce::ValueTree& tree, const juce::Identifier* property)
+{
+    ChangeEvent change;
+    if (!locate(tree, change))
+        return;
+
+    if (property != nullptr)
+    {
+        const int index = getSchemaIndex(change.node, *property);
+        if (index < 0)
+            return;
+
+        change.property = static_cast<uint8_t>(index);
+    }
+
+    pending.push_back(change);
+    triggerAsyncUpdate();
+}
+
+void ChangeDispatcher::handleAsyncUpdate()
+{
+    if (pending.empty())
+        return;
+
+    // Subscribers may edit the model while they are told about it, those edits queue up for the next batch
+    delivering.swap(pending);
+    pending.clear();
+
+    std::ranges::sort(delivering);
+    const auto duplicates = std::ranges::unique(delivering);
+    delivering.erase(duplicates.begin(), duplicates.end());
+
+    subscribers.call([this](Subscriber& subscriber) { subscriber.modelChanged(delivering); });
+    delivering.clear();
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#include <compare>
+#include <cstdint>
+#include <vector>
+
+namespace Sirkus::Core {
+
+// One change to the sequencer's model, addressed by node and schema index rather than by ValueTree
+struct ChangeEvent
+{
+    enum class Node : uint8_t
+    {
+        Sequencer,
+        Track,
+        Pattern,
+        Step
+    };
+
+    static constexpr uint8_t CHILDREN = 0xff; // Children were added, removed or reordered
+
+    // Member order is the sort order: parents come before their children
+    Node node{Node::Sequencer};
+    uint32_t trackId{0};
+    uint16_t pattern{0};
+    uint16_t step{0};
+    uint8_t property{CHILDREN}; // Index in the node's schema
+
+    auto operator<=>(const ChangeEvent&) const = default;
+};
+
+/*
+The one ValueTree listener on the sequencer's tree. Model objects no longer listen to
+their own state: JUCE walks every listener up the parent chain for each property
+change, so a listener per step turned one edit into thousands of checks.
+
+Each change is turned into a ChangeEvent and queued. Properties that aren't in the
+node's schema are ignored. Once per message loop turn the queue is sorted and
+duplicates are dropped, and subscribers get the whole batch at once. Subscribers read
+the model's current values, so ten edits to one step arrive as a single event.
+
+Message thread only.
+*/
+class ChangeDispatcher final
+    : private juce::ValueTree::Listener
+      , private juce::AsyncUpdater
+{
+public:
+    struct Subscriber
+    {
+        virtual ~Subscriber() = default;
+        virtual void modelChanged(const std::vector<ChangeEvent>& changes) = 0;
+    };
+
+    explicit ChangeDispatcher(juce::ValueTree sequencerState);
+    ~ChangeDispatcher() override;
+
+    void addSubscriber(Subscriber* subscriber);
+    void removeSubscriber(Subscriber* subscriber);
+
+    // Deliver whatever is queued now rather than on the next message loop turn
+    void dispatchPendingChanges();
+
+private:
+    void valueTreePropertyChanged(juce::ValueTree& tree, const juce::Identifier& property) override;
+    void valueTreeChildAdded(juce::ValueTree& parent, juce::ValueTree& child) override;
+    void valueTreeChildRemoved(juce::ValueTree& parent, juce::ValueTree& child, int index) override;
+    void valueTreeChildOrderChanged(juce::ValueTree& parent, int oldIndex, int newIndex) override;
+    void handleAsyncUpdate() override;
+
+    // Where the node sits in the tree, false for trees that aren't part of the model
+    bool locate(const juce::ValueTree& tree, ChangeEvent& change) const;
+    void enqueue(const juce::ValueTree& tree, const juce::Identifier* property);
+
+    juce::ValueTree root;
+    std::vector<ChangeEvent> pending;
+    std::vector<ChangeEvent> delivering;
+    juce::ListenerList<Subscriber> subscribers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChangeDispatcher)
+};
+
+} // namespace Sirkus::Core
@@ -0,0 +1,89 @@
+#include "ClockTempoEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace Sirkus::Core {
+
+namespace {
+// A pulse this many periods late means the clock stopped and started again
+constexpr double DROPOUT_PERIODS = 4.0;
+} // namespace
+
+void ClockTempoEstimator::prepare(const double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void ClockTempoEstimator::reset()
+{
+    lastPulseTime = 0.0;
+    nextPulseTime = 0.0;
+    period = 0.0;
+    numPulses = 0;
+}
+
+void ClockTempoEstimator::addPulse(const double sampleTime)
+{
+    if (numPulses == 0)
+    {
+        lastPulseTime = sampleTime;
+        nextPulseTime = sampleTime;
+        numPulses = 1;
+        return;
+    }
+
+    if (numPulses == 1)
+    {
+        // Two pulses give the first period, the loop takes over from here
+        period = sampleTime - lastPulseTime;
+        if (period <= 0.0)
+        {
+            reset();
+            addPulse(sampleTime);
+            return;
+        }
+
+        lastPulseTime = sampleTime;
+        nextPulseTime = sampleTime + period;
+        numPulses = 2;
+        updateCoefficients();
+        return;
+    }
+
+    const double error = sampleTime - nextPulseTime;
+    if (error > DROPOUT_PERIODS * period || error < -period)
+    {
+        reset();
+        addPulse(sampleTime);
+        return;
+    }
+
+    lastPulseTime = nextPulseTime + phaseGain * error;
+    period += periodGain * error;
+    nextPulseTime = lastPulseTime + period;
+    ++numPulses;
+
+    updateCoefficients();
+}
+
+double ClockTempoEstimator::getBpm(const int pulsesPerQuarterNote) const
+{
+    if (!hasEstimate() || period <= 0.0 || pulsesPerQuarterNote <= 0)
+        return 0.0;
+
+    return 60.0 * sampleRate / (period * pulsesPerQuarterNote);
+}
+
+void ClockTempoEstimator::updateCoefficients()
+{
+    // Damping of 1/sqrt(2) rather than critical: a tempo step overshoots by a few percent of
+    // its size but settles in about half the time. Bandwidth is relative to the pulse rate
+    const double omega = 2.0 * std::numbers::pi * bandwidthHz * period / sampleRate;
+    phaseGain = std::min(1.0, std::numbers::sqrt2 * omega);
+    periodGain = std::min(1.0, omega * omega);
+}
+
+} // namespace Sirkus::Core
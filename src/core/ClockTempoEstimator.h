@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Smooths the arrival times of incoming clock pulses with a second-order delay-locked
+loop, giving a steady pulse period and a filtered time for the latest pulse.
+
+Each pulse is compared with the time the loop predicted for it. A fraction of the
+error corrects the phase and a smaller fraction corrects the period, so transport
+jitter averages out while a real tempo change is followed within a few beats. The
+bandwidth sets that trade-off. Times are in samples, and nothing here depends on
+JUCE, so the estimator can be fed synthetic pulse streams directly.
+*/
+class ClockTempoEstimator
+{
+public:
+    static constexpr double DEFAULT_BANDWIDTH_HZ = 1.0;
+    static constexpr int PULSES_TO_LOCK = 24;
+
+    ClockTempoEstimator() = default;
+
+    void prepare(double sampleRate);
+    void setBandwidth(double hz) { bandwidthHz = hz; }
+    void reset();
+
+    // Feed the time of a received pulse. A gap much longer than the current period is
+    // treated as a dropout and the loop starts again from this pulse
+    void addPulse(double sampleTime);
+
+    [[nodiscard]] bool hasEstimate() const { return numPulses >= 2; }
+    [[nodiscard]] bool isLocked() const { return numPulses >= PULSES_TO_LOCK; }
+
+    // Filtered period between pulses, in samples
+    [[nodiscard]] double getPeriod() const { return period; }
+
+    // Filtered time of the most recent pulse, and the predicted time of the next
+    [[nodiscard]] double getLastPulseTime() const { return lastPulseTime; }
+    [[nodiscard]] double getNextPulseTime() const { return nextPulseTime; }
+
+    [[nodiscard]] double getBpm(int pulsesPerQuarterNote) const;
+
+private:
+    void updateCoefficients();
+
+    double sampleRate{44100.0};
+    double bandwidthHz{DEFAULT_BANDWIDTH_HZ};
+
+    double lastPulseTime{0.0};
+    double nextPulseTime{0.0};
+    double period{0.0};
+    double phaseGain{0.0};
+    double periodGain{0.0};
+    int64_t numPulses{0};
+};
+
+} // namespace Sirkus::Core
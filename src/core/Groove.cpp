@@ -0,0 +1,170 @@
+#include "Groove.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Sirkus::Core {
+
+using namespace Sirkus::Constants;
+
+size_t Groove::positionAt(const int tick) const
+{
+    // Floor division so ticks pushed before zero by an offset still find their position
+    const int grid = tick >= 0 ? tick / resolution : -((-tick + resolution - 1) / resolution);
+    const auto count = static_cast<int>(length);
+    return static_cast<size_t>(((grid % count) + count) % count);
+}
+
+int Groove::getTimingOffset(const int tick) const
+{
+    if (isEmpty() || resolution <= 0)
+        return 0;
+
+    return timingOffsets[positionAt(tick)];
+}
+
+int Groove::getVelocityOffset(const int tick) const
+{
+    if (isEmpty() || resolution <= 0)
+        return 0;
+
+    return velocityOffsets[positionAt(tick)];
+}
+
+Groove Groove::fromSwing(const float percent, const int resolution)
+{
+    Groove groove;
+    groove.resolution = std::max(1, resolution);
+
+    const float clamped = juce::jlimit(50.0f, 75.0f, percent);
+    if (clamped <= 50.0f)
+        return groove;
+
+    // The pair spans two positions, the first note takes percent of it
+    groove.length = 2;
+    groove.timingOffsets[1] = static_cast<int16_t>(
+        std::lround((clamped / 50.0f - 1.0f) * static_cast<float>(groove.resolution)));
+    return groove;
+}
+
+Groove Groove::fromMidiFile(const juce::MidiFile& midiFile, const size_t length, const int resolution)
+{
+    Groove groove;
+    groove.resolution = std::max(1, resolution);
+
+    const short timeFormat = midiFile.getTimeFormat();
+    if (timeFormat <= 0 || length == 0)
+        return groove; // SMPTE timing has no beats to measure against
+
+    const size_t positions = std::min(length, MAX_POSITIONS);
+    std::array<double, MAX_POSITIONS> timingSums{};
+    std::array<double, MAX_POSITIONS> velocitySums{};
+    std::array<int, MAX_POSITIONS> counts{};
+    double totalVelocity = 0.0;
+    int totalNotes = 0;
+
+    for (int trackIndex = 0; trackIndex < midiFile.getNumTracks(); ++trackIndex)
+    {
+        const auto* sequence = midiFile.getTrack(trackIndex);
+        if (sequence == nullptr)
+            continue;
+
+        for (int i = 0; i < sequence->getNumEvents(); ++i)
+        {
+            const auto& message = sequence->getEventPointer(i)->message;
+            if (!message.isNoteOn())
+                continue;
+
+            // File ticks to sequencer ticks, then the nearest grid position
+            const auto tick = static_cast<int64_t>(std::llround(message.getTimeStamp() * PPQN / timeFormat));
+            const int64_t grid = (tick + groove.resolution / 2) / groove.resolution;
+            const auto position = static_cast<size_t>(grid % static_cast<int64_t>(positions));
+
+            timingSums[position] += static_cast<double>(tick - grid * groove.resolution);
+            velocitySums[position] += message.getVelocity();
+            ++counts[position];
+            totalVelocity += message.getVelocity();
+            ++totalNotes;
+        }
+    }
+
+    if (totalNotes == 0)
+        return groove;
+
+    const double meanVelocity = totalVelocity / totalNotes;
+    const int maxOffset = groove.resolution / 2;
+
+    groove.length = positions;
+    for (size_t position = 0; position < positions; ++position)
+    {
+        // Positions nobody played stay on the grid
+        if (counts[position] == 0)
+            continue;
+
+        const double timing = timingSums[position] / counts[position];
+        const double velocity = velocitySums[position] / counts[position] - meanVelocity;
+        groove.timingOffsets[position] =
+            static_cast<int16_t>(std::clamp(static_cast<int>(std::lround(timing)), -maxOffset, maxOffset));
+        groove.velocityOffsets[position] = static_cast<int8_t>(std::clamp(
+            static_cast<int>(std::lround(velocity)),
+            static_cast<int>(std::numeric_limits<int8_t>::min()),
+            static_cast<int>(std::numeric_limits<int8_t>::max())));
+    }
+
+    return groove;
+}
+
+std::optional<Groove> Groove::loadMidiFile(const juce::File& file, const size_t length, const int resolution)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+        return std::nullopt;
+
+    juce::MidiFile midiFile;
+    if (!midiFile.readFrom(stream))
+        return std::nullopt;
+
+    return fromMidiFile(midiFile, length, resolution);
+}
+
+juce::String Groove::toString() const
+{
+    if (isEmpty())
+        return {};
+
+    juce::String text(resolution);
+    text << ":";
+    for (size_t position = 0; position < length; ++position)
+    {
+        if (position > 0)
+            text << ",";
+        text << static_cast<int>(timingOffsets[position]) << "/" << static_cast<int>(velocityOffsets[position]);
+    }
+    return text;
+}
+
+Groove Groove::fromString(const juce::String& text)
+{
+    Groove groove;
+    if (text.isEmpty())
+        return groove;
+
+    groove.resolution = std::max(1, text.upToFirstOccurrenceOf(":", false, false).getIntValue());
+
+    const auto positions = juce::StringArray::fromTokens(text.fromFirstOccurrenceOf(":", false, false), ",", "");
+    groove.length = std::min(static_cast<size_t>(positions.size()), MAX_POSITIONS);
+    for (size_t position = 0; position < groove.length; ++position)
+    {
+        const auto& entry = positions[static_cast<int>(position)];
+        groove.timingOffsets[position] =
+            static_cast<int16_t>(entry.upToFirstOccurrenceOf("/", false, false).getIntValue());
+        groove.velocityOffsets[position] = static_cast<int8_t>(juce::jlimit(
+            -128,
+            127,
+            entry.fromFirstOccurrenceOf("/", false, false).getIntValue()));
+    }
+    return groove;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Constants.h"
+#include "../JuceHeader.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace Sirkus::Core {
+
+/*
+A groove template: timing and velocity offsets for each position of a repeating grid,
+by default one bar of sixteenths.
+
+A pattern applies its groove while it compiles its trigger data, so the offsets are
+already part of the trigger ticks by the time the audio thread sees them. It is a
+plain value so it can be kept per pattern and stored as a single string property.
+*/
+struct Groove
+{
+    static constexpr size_t MAX_POSITIONS = 64;
+    static constexpr int DEFAULT_RESOLUTION = Constants::STEP_16TH;
+
+    int resolution{DEFAULT_RESOLUTION}; // Ticks between grid positions
+    size_t length{0};                   // Positions before the groove repeats, 0 for none
+    std::array<int16_t, MAX_POSITIONS> timingOffsets{};
+    std::array<int8_t, MAX_POSITIONS> velocityOffsets{};
+
+    [[nodiscard]] bool isEmpty() const { return length == 0; }
+
+    // Offsets for whatever sits at a pattern tick, taken from the grid position it falls in
+    [[nodiscard]] int getTimingOffset(int tick) const;
+    [[nodiscard]] int getVelocityOffset(int tick) const;
+
+    // MPC-style swing: the second of each pair of positions is pushed back so the first
+    // takes up percent of the pair. 50 is straight, 66 close to a triplet feel
+    static Groove fromSwing(float percent, int resolution = DEFAULT_RESOLUTION);
+
+    // Averages where the notes of a performance fall around the grid, and how hard they
+    // are played relative to the whole performance
+    static Groove fromMidiFile(
+        const juce::MidiFile& midiFile,
+        size_t length = 16,
+        int resolution = DEFAULT_RESOLUTION);
+
+    static std::optional<Groove> loadMidiFile(
+        const juce::File& file,
+        size_t length = 16,
+        int resolution = DEFAULT_RESOLUTION);
+
+    // "resolution:timing/velocity,timing/velocity,...", empty for no groove
+    [[nodiscard]] juce::String toString() const;
+    static Groove fromString(const juce::String& text);
+
+private:
+    [[nodiscard]] size_t positionAt(int tick) const;
+};
+
+} // namespace Sirkus::Core
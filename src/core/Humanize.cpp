@@ -0,0 +1,22 @@
+#include "Humanize.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core::Humanize {
+
+void apply(ActiveStep* steps, const size_t numSteps, const HumanizeSettings& settings, const uint32_t trackId)
+{
+    const int timingTicks = std::clamp(settings.timingTicks, 0, HumanizeSettings::MAX_TIMING_TICKS);
+    const int velocity = std::clamp(settings.velocity, 0, HumanizeSettings::MAX_VELOCITY);
+    const uint64_t trackKey = (static_cast<uint64_t>(settings.seed) << 32) ^ hash(trackId);
+
+    for (size_t i = 0; i < numSteps; ++i)
+    {
+        // Keyed on where the trigger is written, not where it ends up
+        const uint64_t bits = hash(trackKey ^ static_cast<uint64_t>(static_cast<uint32_t>(steps[i].tick)));
+        steps[i].tick += bipolar(static_cast<uint32_t>(bits >> 32), timingTicks);
+        steps[i].velocityOffset += bipolar(static_cast<uint32_t>(bits), velocity);
+    }
+}
+
+} // namespace Sirkus::Core::Humanize
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../Constants.h"
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+// How far a track's triggers may be pushed either way in ticks, and how much their velocity may vary
+struct HumanizeSettings
+{
+    static constexpr int MAX_TIMING_TICKS = Constants::PPQN / 4;
+    static constexpr int MAX_VELOCITY = 64;
+
+    int timingTicks{0};
+    int velocity{0};
+    uint32_t seed{0};
+
+    [[nodiscard]] bool isActive() const { return timingTicks > 0 || velocity > 0; }
+};
+
+namespace Humanize {
+
+/*
+The variation for each trigger is a hash of the seed, the track and the trigger's
+absolute tick. No generator state is carried from one block to the next, so the same
+seed gives the same performance at any buffer size, after a seek and on every render.
+
+A trigger can be pulled up to timingTicks earlier, into the block before the one it is
+written in. Callers look for triggers timingTicks either side of the block, apply the
+humanize stage, and then only play the triggers that land inside it. After a seek or a
+loop there is no block before, so the triggers pulled in front of the new position play
+on its first tick.
+*/
+
+// The same 64-bit mixing function as splitmix64, without the counter
+[[nodiscard]] constexpr uint64_t hash(uint64_t key)
+{
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
+
+// Map 32 random bits onto [-amount, amount]
+[[nodiscard]] constexpr int bipolar(const uint32_t bits, const int amount)
+{
+    const auto span = static_cast<uint64_t>(2 * amount + 1);
+    return static_cast<int>((static_cast<uint64_t>(bits) * span) >> 32) - amount;
+}
+
+// Jitter the triggers in place. Branch-free over a flat array so it can be vectorised
+void apply(ActiveStep* steps, size_t numSteps, const HumanizeSettings& settings, uint32_t trackId);
+
+} // namespace Humanize
+
+} // namespace Sirkus::Core
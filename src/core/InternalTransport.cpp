@@ -2,107 +2,159 @@
 
 #include "../Constants.h"
 
+#include <cmath>
 #include <utility>
 
 namespace Sirkus::Core {
 
 InternalTransport::InternalTransport()
     : sampleRate(44100.0)
-      , bpm(120.0)
-      , ppqPosition(0.0)
-      , samplesPerQuarterNote(0.0)
       , playing(false)
-      , timeSigNumerator(4)
-      , timeSigDenominator(4)
 {
-    updateTimingInfo();
+    publishTempoMap();
+    applyPendingChanges();
 }
 
 void InternalTransport::prepare(double newSampleRate)
 {
     sampleRate = newSampleRate;
-    updateTimingInfo();
+    publishTempoMap();
+    applyPendingChanges();
 }
 
 void InternalTransport::processBlock(int numSamples)
 {
-    if (!playing)
-        return;
-
-    ppqPosition += (numSamples / samplesPerQuarterNote);
-    updateMusicalPosition();
+    applyPendingChanges();
+
+    if (tempoMap->isConstant())
+    {
+        blockTiming = BlockTiming::fromRate(anchorTick, anchorSample - sampleCount, rateTicks, rateSamples, numSamples);
+    }
+    else
+    {
+        blockTiming = BlockTiming::fromTempoMap(*tempoMap, static_cast<double>(mapOriginSample + sampleCount), numSamples);
+    }
+
+    const double tick = getExactTick();
+    const auto [numerator, denominator] = tempoMap->getTimeSignatureAtTick(tick);
+    timingInfo = TimingInfo{};
+    timingInfo.setPpqPosition(tick / Sirkus::Constants::PPQN);
+    timingInfo.setBpm(tempoMap->getBpmAtTick(tick));
+    timingInfo.setMusicalPosition(tempoMap->getMusicalPosition(tick));
+    timingInfo.setTimeSignature(numerator, denominator);
+    timingInfo.isPlaying = isPlaying();
+
+    if (timingInfo.isPlaying)
+        sampleCount += numSamples;
 }
 
-TimingInfo InternalTransport::getTimingInfo() const
+void InternalTransport::setBpm(double newBpm)
 {
-    TimingInfo info;
-    info.ppqPosition = ppqPosition;
-    info.bpm = bpm;
-    info.musicalPosition = musicalPosition;
-    info.timeSignature = std::make_pair(timeSigNumerator, timeSigDenominator);
-    info.isPlaying = playing;
-    return info;
+    editedTempoMap.setTempo(newBpm);
+    publishTempoMap();
 }
 
-void InternalTransport::setBpm(double newBpm)
+void InternalTransport::setTimeSignature(int numerator, int denominator)
 {
-    bpm = newBpm;
-    updateTimingInfo();
+    editedTempoMap.setTimeSignature(numerator, denominator);
+    publishTempoMap();
 }
 
-void InternalTransport::setTimeSignature(int numerator, int denominator)
+void InternalTransport::setTempoMap(const TempoMap& newTempoMap)
 {
-    timeSigNumerator = numerator;
-    timeSigDenominator = denominator;
-    updateMusicalPosition();
+    editedTempoMap = newTempoMap;
+    publishTempoMap();
 }
 
 void InternalTransport::start()
 {
-    playing = true;
+    playing.store(true, std::memory_order_relaxed);
 }
 
 void InternalTransport::stop()
 {
-    playing = false;
+    playing.store(false, std::memory_order_relaxed);
 }
 
 void InternalTransport::setPositionInBars(int bar, int beat, double tick)
 {
-    musicalPosition.bar = bar;
-    musicalPosition.beat = beat;
-    musicalPosition.tick = tick;
-
-    // Convert bar/beat/tick to PPQ
-    const double beatsPerBar = timeSigNumerator * (4.0 / timeSigDenominator);
-    const double totalBeats = (bar - 1) * beatsPerBar + (beat - 1) + (tick / Sirkus::Constants::PPQN);
-    ppqPosition = totalBeats * (4.0 / timeSigDenominator);
+    // Bars follow the meter changes in the map, beats are the meter's denominator and
+    // tick is the fraction of a beat in PPQN, like MusicalPosition
+    const int64_t barTick = editedTempoMap.barToTick(bar);
+    const int denominator = editedTempoMap.getTimeSignatureAtTick(static_cast<double>(barTick)).second;
+    const double ticksPerBeat = Sirkus::Constants::PPQN * 4.0 / denominator;
+    const double positionTick =
+        static_cast<double>(barTick) + ((beat - 1) + tick / Sirkus::Constants::PPQN) * ticksPerBeat;
+
+    pendingPositionTick.store(positionTick, std::memory_order_release);
 }
 
-void InternalTransport::updateTimingInfo()
+void InternalTransport::publishTempoMap()
 {
-    samplesPerQuarterNote = (60.0 / bpm) * sampleRate;
+    editedTempoMap.prepare(sampleRate);
+    publishedTempoMaps.write(editedTempoMap);
 }
 
-void InternalTransport::updateMusicalPosition()
+void InternalTransport::applyPendingChanges()
 {
-    const auto timeSig = std::make_pair(timeSigNumerator, timeSigDenominator);
-    const double beatsPerBar = timeSig.first * (4.0 / timeSig.second);
-    const double totalBeats = ppqPosition * (timeSig.second / 4.0);
+    if (tempoMap == nullptr || publishedTempoMaps.hasNewValue())
+    {
+        // Keep the position where it is in ticks and carry on from there with the new map.
+        // The tick comes from the map it was played with, which reading hands back to the writer
+        const double tick = tempoMap != nullptr ? getExactTick() : 0.0;
+        tempoMap = &publishedTempoMaps.read();
+
+        if (tempoMap->isConstant())
+            BlockTiming::tempoToRate(tempoMap->getTempoEvent(0).bpm, sampleRate, rateTicks, rateSamples);
+
+        setPositionTick(tick);
+    }
+
+    const double requested = pendingPositionTick.exchange(NO_PENDING_POSITION, std::memory_order_acquire);
+    if (requested != NO_PENDING_POSITION)
+        setPositionTick(requested);
+}
 
-    musicalPosition.bar = static_cast<int>(totalBeats / beatsPerBar) + 1;
-    musicalPosition.beat = static_cast<int>(std::fmod(totalBeats, beatsPerBar)) + 1;
-    musicalPosition.tick = std::fmod(totalBeats, 1.0) * Sirkus::Constants::PPQN;
+void InternalTransport::setPositionTick(const double tick)
+{
+    if (tempoMap->isConstant())
+    {
+        // Anchor on the last whole tick, placed where it fell at the current rate. Only
+        // the sub-sample part is rounded, once per change
+        const double wholeTick = std::floor(tick);
+        anchorTick = static_cast<int64_t>(wholeTick);
+        anchorSample = sampleCount - std::llround(
+            (tick - wholeTick) * static_cast<double>(rateSamples) / static_cast<double>(rateTicks));
+    }
+    else
+    {
+        // Likewise rounded to a whole sample once, so every block after maps an exact sample
+        size_t segment = 0;
+        mapOriginSample = std::llround(tempoMap->tickToSample(tick, segment)) - sampleCount;
+    }
 }
 
-double InternalTransport::ppqPositionToBeats(double ppq) const
+double InternalTransport::getExactTick() const
 {
-    return ppq * (timeSigDenominator / 4.0);
+    if (tempoMap->isConstant())
+    {
+        int64_t ticksSinceAnchor = 0;
+        double tickFraction = 0.0;
+        splitPosition(ticksSinceAnchor, tickFraction);
+        return static_cast<double>(anchorTick + ticksSinceAnchor) + tickFraction;
+    }
+
+    size_t segment = 0;
+    return tempoMap->sampleToTick(static_cast<double>(mapOriginSample + sampleCount), segment);
 }
 
-double InternalTransport::beatsToNextBar(const MusicalPosition& pos) const
+void InternalTransport::splitPosition(int64_t& ticksSinceAnchor, double& tickFraction) const
 {
-    const double beatsPerBar = timeSigNumerator * (4.0 / timeSigDenominator);
-    return beatsPerBar - ((pos.beat - 1) + (pos.tick / Sirkus::Constants::PPQN));
+    const int64_t elapsed = sampleCount - anchorSample;
+    ticksSinceAnchor = mulDivFloor(elapsed, rateTicks, rateSamples);
+
+    const auto remainder = static_cast<__int128>(elapsed) * rateTicks -
+        static_cast<__int128>(ticksSinceAnchor) * rateSamples;
+    tickFraction = static_cast<double>(remainder) / static_cast<double>(rateSamples);
 }
 } // namespace Sirkus::Core
@@ -1,42 +1,84 @@
 #pragma once
 
+#include "BlockTiming.h"
+#include "TempoMap.h"
 #include "TimingInfo.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <cstdint>
 
 namespace Sirkus::Core {
+
+/*
+Standalone transport. Position is never integrated: it is derived from a 64-bit count
+of played samples, so a long run lands on exactly the same samples regardless of the
+buffer size it was played with.
+
+With a single tempo the position is an anchor (a whole tick and the sample it fell on)
+plus an exact integer ratio. Once the tempo map has changes or ramps, the played
+sample count is mapped through it instead, from a whole-sample origin in the map.
+
+Tempo, meter and position edits come from the message thread. The edited tempo map is
+handed over through a triple buffer, and everything takes effect at the start of the
+next block.
+*/
 class InternalTransport
 {
 public:
     InternalTransport();
 
     void prepare(double sampleRate);
+
+    // Audio thread: pick up edits, fix this block's timing, then advance
     void processBlock(int numSamples);
 
-    // Get complete timing info
-    [[nodiscard]] TimingInfo getTimingInfo() const;
+    // The block most recently processed, as seen from its first sample
+    [[nodiscard]] TimingInfo getTimingInfo() const { return timingInfo; }
+    [[nodiscard]] const BlockTiming& getBlockTiming() const { return blockTiming; }
 
     // Transport controls
-    void setBpm(double newBpm);
+    void setBpm(double newBpm); // Replaces the tempo map with a single tempo
     void setTimeSignature(int numerator, int denominator);
+    void setTempoMap(const TempoMap& newTempoMap);
+    [[nodiscard]] const TempoMap& getTempoMap() const { return editedTempoMap; }
     void start();
     void stop();
     void setPositionInBars(int bar, int beat = 1, double tick = 0.0);
 
-    [[nodiscard]] bool isPlaying() const { return playing; }
+    [[nodiscard]] bool isPlaying() const { return playing.load(std::memory_order_relaxed); }
 
 private:
+    static constexpr double NO_PENDING_POSITION = -1.0e300;
+
+    void publishTempoMap();
+    void applyPendingChanges();
+    void setPositionTick(double tick);
+    [[nodiscard]] double getExactTick() const;
+    void splitPosition(int64_t& ticksSinceAnchor, double& tickFraction) const;
+
     double sampleRate;
-    double bpm;
-    double ppqPosition;
-    double samplesPerQuarterNote;
-    bool playing;
-
-    int timeSigNumerator;
-    int timeSigDenominator;
-    MusicalPosition musicalPosition;
-
-    void updateTimingInfo();
-    void updateMusicalPosition();
-    [[nodiscard]] double ppqPositionToBeats(double ppq) const;
-    [[nodiscard]] double beatsToNextBar(const MusicalPosition& pos) const;
+    std::atomic<bool> playing;
+    std::atomic<double> pendingPositionTick{NO_PENDING_POSITION};
+
+    // Message thread copy, edited and then published
+    TempoMap editedTempoMap;
+    TripleBuffer<TempoMap> publishedTempoMaps;
+
+    // Audio thread state
+    const TempoMap* tempoMap{nullptr};
+    int64_t sampleCount{0};
+
+    // Single tempo: anchorTick fell on sample anchorSample of the played sample count
+    int64_t anchorTick{0};
+    int64_t anchorSample{0};
+    int64_t rateTicks{1};
+    int64_t rateSamples{1};
+
+    // Tempo map: played sample n sits at sample mapOriginSample + n of the map
+    int64_t mapOriginSample{0};
+
+    BlockTiming blockTiming;
+    TimingInfo timingInfo;
 };
 } // namespace Sirkus::Core
@@ -0,0 +1,128 @@
+#include "KeyboardControl.h"
+
+#include <bit>
+
+namespace Sirkus::Core {
+
+KeyboardControl::KeyboardControl() = default;
+
+void KeyboardControl::processBlock(const juce::MidiBuffer& midiIn)
+{
+    const int channel = getControlChannel();
+    if (channel == 0)
+        return;
+
+    const uint16_t previousPitchClasses = heldPitchClasses;
+    const int previousLowest = lowestHeldNote();
+
+    for (const auto metadata : midiIn)
+    {
+        if (metadata.numBytes < 3 || (metadata.data[0] & 0x0F) + 1 != channel)
+            continue;
+
+        const auto status = static_cast<uint8_t>(metadata.data[0] & 0xF0);
+        const auto note = static_cast<uint8_t>(metadata.data[1] & 0x7F);
+
+        if (status == 0x90 && metadata.data[2] > 0)
+            noteOn(note);
+        else if (status == 0x80 || status == 0x90)
+            noteOff(note);
+    }
+
+    // Releasing every key keeps the last scale rather than falling back to nothing
+    const int lowest = lowestHeldNote();
+    if (lowest >= 0 && (heldPitchClasses != previousPitchClasses || lowest % 12 != previousLowest % 12))
+        updateFollowedScale();
+
+    publishedTranspose.store(transpose, std::memory_order_relaxed);
+}
+
+const juce::MidiBuffer& KeyboardControl::removeControlMessages(
+    const juce::MidiBuffer& midiIn,
+    juce::MidiBuffer& filtered) const
+{
+    const int channel = getControlChannel();
+    if (channel == 0)
+        return midiIn;
+
+    filtered.clear();
+    for (const auto metadata : midiIn)
+    {
+        // System messages have no channel and always pass
+        const juce::uint8 status = metadata.numBytes > 0 ? metadata.data[0] : 0;
+        if (status >= 0x80 && status < 0xF0 && (status & 0x0F) + 1 == channel)
+            continue;
+
+        filtered.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+    }
+    return filtered;
+}
+
+void KeyboardControl::reset()
+{
+    heldMask = {};
+    pitchClassCounts = {};
+    heldPitchClasses = 0;
+    transpose = 0;
+    hasFollowedScale = false;
+    publishedTranspose.store(0, std::memory_order_relaxed);
+    publishedPitchClasses.store(0, std::memory_order_relaxed);
+}
+
+const ScaleTable* KeyboardControl::getFollowedScale() const
+{
+    return isScaleFollowEnabled() && hasFollowedScale ? &followedScale : nullptr;
+}
+
+void KeyboardControl::noteOn(const uint8_t note)
+{
+    transpose = static_cast<int>(note) - getReferenceNote();
+
+    if (isHeld(note))
+        return;
+
+    heldMask[note >> 6] |= uint64_t{1} << (note & 63);
+
+    const size_t pitchClass = note % 12;
+    if (pitchClassCounts[pitchClass]++ == 0)
+        heldPitchClasses = static_cast<uint16_t>(heldPitchClasses | (1u << pitchClass));
+}
+
+void KeyboardControl::noteOff(const uint8_t note)
+{
+    if (!isHeld(note))
+        return;
+
+    heldMask[note >> 6] &= ~(uint64_t{1} << (note & 63));
+
+    const size_t pitchClass = note % 12;
+    if (--pitchClassCounts[pitchClass] == 0)
+        heldPitchClasses = static_cast<uint16_t>(heldPitchClasses & ~(1u << pitchClass));
+}
+
+void KeyboardControl::updateFollowedScale()
+{
+    const int lowest = lowestHeldNote();
+    if (lowest < 0)
+        return;
+
+    followedScale = ScaleTable::fromPitchClasses(heldPitchClasses, static_cast<uint8_t>(lowest % 12));
+    hasFollowedScale = true;
+    publishedPitchClasses.store(heldPitchClasses, std::memory_order_relaxed);
+}
+
+bool KeyboardControl::isHeld(const uint8_t note) const
+{
+    return (heldMask[note >> 6] & (uint64_t{1} << (note & 63))) != 0;
+}
+
+int KeyboardControl::lowestHeldNote() const
+{
+    if (heldMask[0] != 0)
+        return std::countr_zero(heldMask[0]);
+    if (heldMask[1] != 0)
+        return 64 + std::countr_zero(heldMask[1]);
+    return -1;
+}
+
+} // namespace Sirkus::Core
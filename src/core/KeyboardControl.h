@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "ScaleTable.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Keyboard transpose and scale follow, driven by notes arriving on a control channel.
+
+The most recently pressed note transposes the tracks relative to the reference note.
+With scale follow on, the held notes also define the scale: the lowest one is the root
+and every held pitch class becomes a degree. Both latch when the keys are released.
+
+Held notes are tracked on the audio thread in a 128-bit mask plus a count per pitch
+class, so each note-on/off is a constant-time update and the scale table is only
+rebuilt when the set of held pitch classes actually changes.
+*/
+class KeyboardControl
+{
+public:
+    static constexpr int DEFAULT_REFERENCE_NOTE = 60; // Middle C plays the pattern as written
+
+    KeyboardControl();
+
+    // Message thread. Channel 0 turns keyboard control off
+    void setControlChannel(int channel) { controlChannel.store(juce::jlimit(0, 16, channel), std::memory_order_relaxed); }
+    void setReferenceNote(int note) { referenceNote.store(juce::jlimit(0, 127, note), std::memory_order_relaxed); }
+    void setScaleFollow(bool shouldFollow) { scaleFollow.store(shouldFollow, std::memory_order_relaxed); }
+
+    [[nodiscard]] int getControlChannel() const { return controlChannel.load(std::memory_order_relaxed); }
+    [[nodiscard]] int getReferenceNote() const { return referenceNote.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool isScaleFollowEnabled() const { return scaleFollow.load(std::memory_order_relaxed); }
+
+    // Any thread, the last values the audio thread settled on
+    [[nodiscard]] int getCurrentTranspose() const { return publishedTranspose.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint16_t getFollowedPitchClasses() const { return publishedPitchClasses.load(std::memory_order_relaxed); }
+
+    // Audio thread
+    void processBlock(const juce::MidiBuffer& midiIn);
+    void reset();
+
+    // Copy midiIn without the control channel's messages, which steer the tracks rather
+    // than being played. Returns midiIn itself when keyboard control is off
+    const juce::MidiBuffer& removeControlMessages(const juce::MidiBuffer& midiIn, juce::MidiBuffer& filtered) const;
+
+    [[nodiscard]] int getTranspose() const { return transpose; }
+
+    // The scale defined by the held notes, or nullptr if scale follow is off or
+    // nothing has been played yet
+    [[nodiscard]] const ScaleTable* getFollowedScale() const;
+
+private:
+    void noteOn(uint8_t note);
+    void noteOff(uint8_t note);
+    void updateFollowedScale();
+    [[nodiscard]] bool isHeld(uint8_t note) const;
+    [[nodiscard]] int lowestHeldNote() const;
+
+    std::atomic<int> controlChannel{0};
+    std::atomic<int> referenceNote{DEFAULT_REFERENCE_NOTE};
+    std::atomic<bool> scaleFollow{false};
+
+    std::atomic<int> publishedTranspose{0};
+    std::atomic<uint16_t> publishedPitchClasses{0};
+
+    // Audio thread state
+    std::array<uint64_t, 2> heldMask{};
+    std::array<uint8_t, 12> pitchClassCounts{};
+    uint16_t heldPitchClasses{0};
+    int transpose{0};
+    ScaleTable followedScale;
+    bool hasFollowedScale{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(KeyboardControl)
+};
+
+} // namespace Sirkus::Core
@@ -0,0 +1,119 @@
+#include "MidiBufferUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+namespace Sirkus::Core::MidiBufferUtils {
+
+namespace {
+
+// The number of bytes addEvent keeps of data, 0 if it would drop the event
+int getEventLength(const juce::uint8* data, const int maxBytes)
+{
+    if (maxBytes <= 0 || data[0] < 0x80)
+        return 0;
+
+    // Sysex runs to its end marker, meta events are kept whole
+    if (data[0] == 0xF0 || data[0] == 0xF7)
+    {
+        const auto* end = std::find(data + 1, data + maxBytes, juce::uint8{0xF7});
+        return end == data + maxBytes ? maxBytes : static_cast<int>(end - data) + 1;
+    }
+
+    if (data[0] == 0xFF)
+        return maxBytes;
+
+    return std::min(maxBytes, juce::MidiMessage::getMessageLengthFromFirstByte(data[0]));
+}
+
+void writeEvent(juce::MidiBuffer& buffer, const juce::uint8* data, const int numBytes, const int samplePosition)
+{
+    std::array<juce::uint8, EVENT_HEADER_BYTES> header{};
+    const auto position = static_cast<int32_t>(samplePosition);
+    const auto size = static_cast<uint16_t>(numBytes);
+    std::memcpy(header.data(), &position, sizeof(position));
+    std::memcpy(header.data() + sizeof(position), &size, sizeof(size));
+
+    buffer.data.addArray(header.data(), static_cast<int>(header.size()));
+    buffer.data.addArray(data, numBytes);
+}
+
+bool checkLayout()
+{
+    // A channel message, a single byte realtime message on the same sample and a sysex
+    // further on, written both ways
+    constexpr juce::uint8 noteOn[] = {0x90, 0x3C, 0x64};
+    constexpr juce::uint8 clock[] = {0xF8};
+    constexpr juce::uint8 sysex[] = {0xF0, 0x7D, 0x01, 0x02, 0xF7};
+    constexpr int laterSample = 70000; // Needs more than 16 bits
+
+    juce::MidiBuffer expected;
+    expected.addEvent(noteOn, sizeof(noteOn), 0);
+    expected.addEvent(clock, sizeof(clock), 0);
+    expected.addEvent(sysex, sizeof(sysex), laterSample);
+
+    juce::MidiBuffer written;
+    writeEvent(written, noteOn, sizeof(noteOn), 0);
+    writeEvent(written, clock, sizeof(clock), 0);
+    writeEvent(written, sysex, sizeof(sysex), laterSample);
+
+    if (written.data != expected.data)
+        return false;
+
+    // And the buffer reads back what was written
+    int numEvents = 0;
+    for (const auto metadata : written)
+    {
+        const int wantedBytes = numEvents == 0 ? 3 : (numEvents == 1 ? 1 : 5);
+        const int wantedSample = numEvents == 2 ? laterSample : 0;
+        if (metadata.numBytes != wantedBytes || metadata.samplePosition != wantedSample)
+            return false;
+        ++numEvents;
+    }
+
+    return numEvents == 3;
+}
+
+} // namespace
+
+bool canAppendDirectly()
+{
+    static const bool layoutMatches = [] {
+        const bool matches = checkLayout();
+        jassert(matches); // MidiBuffer's layout has changed, so appending is quadratic again
+        return matches;
+    }();
+    return layoutMatches;
+}
+
+void appendInOrder(juce::MidiBuffer& buffer, const juce::uint8* data, const int numBytes, const int samplePosition)
+{
+    if (!canAppendDirectly())
+    {
+        buffer.addEvent(data, numBytes, samplePosition);
+        return;
+    }
+
+    const int length = getEventLength(data, numBytes);
+    if (length <= 0 || length > std::numeric_limits<uint16_t>::max())
+        return;
+
+    writeEvent(buffer, data, length, samplePosition);
+}
+
+void appendAll(juce::MidiBuffer& buffer, const juce::MidiBuffer& source)
+{
+    if (!canAppendDirectly())
+    {
+        for (const auto metadata : source)
+            buffer.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+        return;
+    }
+
+    // Already in the buffer's own layout, so one copy of the bytes
+    buffer.data.addArray(source.data.begin(), source.data.size());
+}
+
+} // namespace Sirkus::Core::MidiBufferUtils
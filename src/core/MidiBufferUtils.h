@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Sirkus::Core::MidiBufferUtils {
+
+/*
+Adds events to the end of a MidiBuffer in constant time, for events already in sample
+order. MidiBuffer::addEvent walks the buffer from the start to find where each event
+goes, so building a block's output with it is quadratic in the number of events.
+
+Appending writes onto the buffer's public data array in the layout addEvent itself uses.
+JUCE doesn't promise to keep that layout, so it is checked once against what addEvent
+writes, and everything falls back to addEvent if they differ. With the buffer reserved
+with ensureSize(), appending never allocates.
+*/
+
+// What a MidiBuffer stores before each event's bytes: an int32 sample position and a uint16 size
+inline constexpr size_t EVENT_HEADER_BYTES = sizeof(int32_t) + sizeof(uint16_t);
+
+// Whether events can be appended directly. The check runs on the first call, so make it
+// from prepare() rather than the audio thread
+bool canAppendDirectly();
+
+// Add an event at or after every event already in buffer
+void appendInOrder(juce::MidiBuffer& buffer, const juce::uint8* data, int numBytes, int samplePosition);
+
+// Add all of source's events to buffer, whose events must be at or before source's first
+void appendAll(juce::MidiBuffer& buffer, const juce::MidiBuffer& source);
+
+} // namespace Sirkus::Core::MidiBufferUtils
@@ -0,0 +1,96 @@
+#include "MidiClockGenerator.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+namespace {
+constexpr int MAX_SONG_POSITION = 0x3FFF;
+} // namespace
+
+MidiClockGenerator::MidiClockGenerator() = default;
+
+void MidiClockGenerator::process(const bool isPlaying, const BlockTiming& timing, MidiEventQueue& midiOut)
+{
+    if (!isEnabled())
+    {
+        reset();
+        return;
+    }
+
+    if (!isPlaying || timing.numSamples <= 0)
+    {
+        if (wasPlaying)
+            midiOut.addEvent(juce::MidiMessage::midiStop(), 0);
+
+        wasPlaying = false;
+        return;
+    }
+
+    const int64_t firstClock = mulDivCeil(timing.startTick, 1, TICKS_PER_CLOCK);
+
+    if (!wasPlaying)
+    {
+        beginFrom(firstClock);
+    }
+    else if (firstClock != nextClock)
+    {
+        // The host looped or relocated, stop the receiver and point it at the new position
+        midiOut.addEvent(juce::MidiMessage::midiStop(), 0);
+        beginFrom(firstClock);
+    }
+
+    wasPlaying = true;
+
+    for (; nextClock * TICKS_PER_CLOCK < timing.endTick; ++nextClock)
+    {
+        const int sampleOffset = timing.tickToSampleOffset(nextClock * TICKS_PER_CLOCK);
+
+        if (resumePending && nextClock >= resumeClock)
+        {
+            if (resumeClock == 0)
+            {
+                midiOut.addEvent(juce::MidiMessage::midiStart(), sampleOffset);
+            }
+            else
+            {
+                const auto sixteenths = static_cast<int>(
+                    std::min<int64_t>(resumeClock / CLOCKS_PER_SIXTEENTH, MAX_SONG_POSITION));
+                midiOut.addEvent(juce::MidiMessage::songPositionPointer(sixteenths), sampleOffset);
+                midiOut.addEvent(juce::MidiMessage::midiContinue(), sampleOffset);
+            }
+            resumePending = false;
+        }
+
+        // Pulses before the resume point would only confuse a receiver that hasn't started yet
+        if (!resumePending)
+            midiOut.addEvent(juce::MidiMessage::midiClock(), sampleOffset);
+    }
+}
+
+void MidiClockGenerator::reset()
+{
+    wasPlaying = false;
+    resumePending = false;
+    nextClock = 0;
+    resumeClock = 0;
+}
+
+void MidiClockGenerator::beginFrom(const int64_t firstClock)
+{
+    // Start is only meaningful from the very beginning, anywhere else resumes on a sixteenth.
+    // Pre-roll before zero waits for zero
+    if (firstClock <= 0)
+    {
+        resumeClock = 0;
+    }
+    else
+    {
+        resumeClock = ((firstClock + CLOCKS_PER_SIXTEENTH - 1) / CLOCKS_PER_SIXTEENTH) * CLOCKS_PER_SIXTEENTH;
+    }
+
+    nextClock = firstClock;
+    resumePending = true;
+}
+
+} // namespace Sirkus::Core
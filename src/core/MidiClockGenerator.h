@@ -0,0 +1,58 @@
+#pragma once
+
+#include "../Constants.h"
+#include "../JuceHeader.h"
+#include "BlockTiming.h"
+#include "MidiEventQueue.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Generates 24 PPQN MIDI clock, start/stop/continue and song position pointer from the
+active transport position.
+
+Every clock pulse sits on a fixed tick, and its sample offset comes from the block's
+exact tick window rather than being accumulated from the previous pulse. Rounding
+therefore never carries from one block to the next, and the output is the same at any
+buffer size.
+
+Starting away from zero, and any jump in the position while playing, sends the song
+position on the next sixteenth followed by Continue, right before that sixteenth's
+clock. That is the point a receiver resumes from.
+*/
+class MidiClockGenerator
+{
+public:
+    static constexpr int CLOCKS_PER_QUARTER_NOTE = 24;
+    static constexpr int CLOCKS_PER_SIXTEENTH = CLOCKS_PER_QUARTER_NOTE / 4;
+    static constexpr int TICKS_PER_CLOCK = Constants::PPQN / CLOCKS_PER_QUARTER_NOTE;
+
+    MidiClockGenerator();
+
+    // Message thread
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    [[nodiscard]] bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread
+    void process(bool isPlaying, const BlockTiming& timing, MidiEventQueue& midiOut);
+
+    void reset();
+
+private:
+    void beginFrom(int64_t firstClock);
+
+    std::atomic<bool> enabled{false};
+
+    // Audio thread state
+    bool wasPlaying{false};
+    int64_t nextClock{0};
+    int64_t resumeClock{0};
+    bool resumePending{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiClockGenerator)
+};
+
+} // namespace Sirkus::Core
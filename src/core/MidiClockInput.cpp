@@ -0,0 +1,120 @@
+#include "MidiClockInput.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+MidiClockInput::MidiClockInput() = default;
+
+void MidiClockInput::prepare(const double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    estimator.prepare(newSampleRate);
+    reset();
+}
+
+void MidiClockInput::reset()
+{
+    estimator.reset();
+    blockStartSample = 0;
+    lastPulseSample = -1;
+    nextPulseIndex = 0;
+    lastPulseIndex = -1;
+    playing = false;
+    startPending = false;
+    ppqPosition = 0.0;
+}
+
+void MidiClockInput::processBlock(const juce::MidiBuffer& midiIn, const int numSamples)
+{
+    for (const auto metadata : midiIn)
+    {
+        if (metadata.numBytes < 1)
+            continue;
+
+        const auto sampleTime = static_cast<double>(blockStartSample + metadata.samplePosition);
+
+        switch (metadata.data[0])
+        {
+            case 0xF8: // Clock
+                handlePulse(sampleTime);
+                break;
+
+            case 0xFA: // Start, the next clock is the first pulse of the song
+                nextPulseIndex = 0;
+                lastPulseIndex = -1;
+                startPending = true;
+                break;
+
+            case 0xFB: // Continue from the current song position
+                startPending = true;
+                break;
+
+            case 0xFC: // Stop
+                playing = false;
+                startPending = false;
+                break;
+
+            case 0xF2: // Song position pointer, in sixteenths
+                if (metadata.numBytes >= 3 && !playing)
+                {
+                    const int sixteenths = (metadata.data[1] & 0x7F) | ((metadata.data[2] & 0x7F) << 7);
+                    nextPulseIndex = static_cast<int64_t>(sixteenths) * (PULSES_PER_QUARTER_NOTE / 4);
+                    lastPulseIndex = nextPulseIndex - 1;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    updatePosition();
+    blockStartSample += numSamples;
+}
+
+bool MidiClockInput::isReceiving() const
+{
+    if (lastPulseSample < 0 || !estimator.hasEstimate())
+        return false;
+
+    return static_cast<double>(blockStartSample - lastPulseSample) < TIMEOUT_SECONDS * sampleRate;
+}
+
+void MidiClockInput::handlePulse(const double sampleTime)
+{
+    // Tempo is tracked from every pulse, running or not
+    estimator.addPulse(sampleTime);
+    lastPulseSample = static_cast<int64_t>(sampleTime);
+
+    if (startPending)
+    {
+        playing = true;
+        startPending = false;
+    }
+
+    if (playing)
+    {
+        lastPulseIndex = nextPulseIndex;
+        ++nextPulseIndex;
+    }
+}
+
+void MidiClockInput::updatePosition()
+{
+    const double period = estimator.getPeriod();
+    if (!playing || !estimator.hasEstimate() || period <= 0.0)
+    {
+        // Stopped, sitting where the next clock will resume from
+        ppqPosition = static_cast<double>(nextPulseIndex) / PULSES_PER_QUARTER_NOTE;
+        return;
+    }
+
+    // Counted position of the last pulse, plus the smoothed time since it. Never run
+    // past the next pulse, if the clock stalls the position holds there
+    const double sinceLastPulse = (static_cast<double>(blockStartSample) - estimator.getLastPulseTime()) / period;
+    const double pulses = static_cast<double>(lastPulseIndex) + std::min(sinceLastPulse, 1.0);
+    ppqPosition = pulses / PULSES_PER_QUARTER_NOTE;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "ClockTempoEstimator.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Follows MIDI clock, start/stop/continue and song position pointer from the input.
+
+Pulses are counted from the last Start or song position, and their sample times feed a
+ClockTempoEstimator. The position at the start of each block is then the count of the
+latest pulse plus the fraction of a smoothed period since its filtered time, so the
+jitter of the incoming stream doesn't reach the sequencer's timing.
+*/
+class MidiClockInput
+{
+public:
+    static constexpr int PULSES_PER_QUARTER_NOTE = 24;
+    static constexpr double TIMEOUT_SECONDS = 0.5;
+
+    MidiClockInput();
+
+    void prepare(double sampleRate);
+    void reset();
+
+    // Audio thread: read this block's clock messages. Must be called once per block
+    void processBlock(const juce::MidiBuffer& midiIn, int numSamples);
+
+    // Whether clock is currently arriving and the tempo estimate can be trusted
+    [[nodiscard]] bool isReceiving() const;
+
+    [[nodiscard]] bool isPlaying() const { return playing; }
+    [[nodiscard]] double getPpqPosition() const { return ppqPosition; }
+    [[nodiscard]] double getBpm() const { return estimator.getBpm(PULSES_PER_QUARTER_NOTE); }
+
+    ClockTempoEstimator& getEstimator() { return estimator; }
+
+private:
+    void handlePulse(double sampleTime);
+    void updatePosition();
+
+    ClockTempoEstimator estimator;
+    double sampleRate{44100.0};
+
+    int64_t blockStartSample{0};
+    int64_t lastPulseSample{-1};
+    int64_t nextPulseIndex{0}; // Pulse count the next clock will carry
+    int64_t lastPulseIndex{-1};
+    bool playing{false};
+    bool startPending{false}; // Playback begins on the first clock after Start/Continue
+    double ppqPosition{0.0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiClockInput)
+};
+
+} // namespace Sirkus::Core
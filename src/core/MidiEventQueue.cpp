@@ -0,0 +1,92 @@
+#include "MidiEventQueue.h"
+
+#include "MidiBufferUtils.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Sirkus::Core {
+
+void MidiEventQueue::prepare(const size_t maximumEvents, const size_t maximumBytes)
+{
+    // Settle how events are written before the audio thread writes any
+    MidiBufferUtils::canAppendDirectly();
+
+    eventCapacity = maximumEvents;
+    byteCapacity = maximumBytes;
+    clear();
+    events.reserve(eventCapacity);
+    bytes.reserve(byteCapacity);
+}
+
+void MidiEventQueue::addEvent(const juce::MidiMessage& message, const int samplePosition)
+{
+    addEvent(message.getRawData(), message.getRawDataSize(), samplePosition);
+}
+
+void MidiEventQueue::addEvent(const juce::uint8* data, const int numBytes, const int samplePosition)
+{
+    // The same limit MidiBuffer has
+    if (numBytes <= 0 || numBytes > std::numeric_limits<uint16_t>::max())
+        return;
+
+    const auto offset = static_cast<uint32_t>(bytes.size());
+    bytes.insert(bytes.end(), data, data + numBytes);
+    events.push_back(
+        Event{samplePosition, static_cast<uint32_t>(events.size()), offset, static_cast<uint32_t>(numBytes)});
+}
+
+void MidiEventQueue::clear()
+{
+    events.clear();
+    bytes.clear();
+    sortedRunStart = NO_SORTED_RUN;
+}
+
+void MidiEventQueue::beginSortedRun()
+{
+    jassert(sortedRunStart == NO_SORTED_RUN);
+    sortedRunStart = events.size();
+}
+
+int MidiEventQueue::getMidiBufferBytes() const
+{
+    return static_cast<int>(eventCapacity * MidiBufferUtils::EVENT_HEADER_BYTES + byteCapacity);
+}
+
+void MidiEventQueue::writeTo(juce::MidiBuffer& midiOut)
+{
+    const auto runStart = events.begin() + static_cast<std::ptrdiff_t>(std::min(sortedRunStart, events.size()));
+
+    // Tracks are processed one after another, so the events arrive as runs that are each
+    // mostly in order. std::sort doesn't allocate, unlike std::stable_sort, and the order
+    // field makes the result stable anyway
+    std::sort(events.begin(), runStart, [](const Event& a, const Event& b) {
+        return a.samplePosition != b.samplePosition ? a.samplePosition < b.samplePosition : a.order < b.order;
+    });
+    jassert(std::is_sorted(runStart, events.end(), [](const Event& a, const Event& b) {
+        return a.samplePosition < b.samplePosition;
+    }));
+
+    // Merge the two runs in one pass, the earlier one first on a shared sample. Each event
+    // goes on the end of midiOut
+    midiOut.clear();
+    auto sorted = events.begin();
+    auto presorted = runStart;
+    while (sorted != runStart || presorted != events.end())
+    {
+        const bool takeSorted =
+            presorted == events.end() || (sorted != runStart && sorted->samplePosition <= presorted->samplePosition);
+        const Event& event = takeSorted ? *sorted++ : *presorted++;
+
+        MidiBufferUtils::appendInOrder(
+            midiOut,
+            bytes.data() + event.offset,
+            static_cast<int>(event.numBytes),
+            event.samplePosition);
+    }
+
+    clear();
+}
+
+} // namespace Sirkus::Core
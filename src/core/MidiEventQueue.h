@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Sirkus::Core {
+
+/*
+Collects the MIDI the plugin outputs in one block, then writes it to the output buffer
+in sample order in one pass.
+
+Events are appended to arrays reserved in prepare(), whatever order they arrive in, and
+sorted once by sample position at the end of the block. Events on the same sample keep
+the order they were added in, just as MidiBuffer::addEvent keeps them.
+
+The last events of a block can instead be added as a run already in sample order, such
+as the host's input passed through. The run isn't sorted, it is merged with the sorted
+events in one linear pass, and loses ties to them. Either way events are appended to
+the output in order, see MidiBufferUtils, so writing a block costs the same per event
+however many there are.
+
+Past the reserved capacity it still works, at the cost of an allocation. Audio thread only,
+apart from prepare().
+*/
+class MidiEventQueue
+{
+public:
+    MidiEventQueue() = default;
+
+    void prepare(size_t maximumEvents, size_t maximumBytes);
+
+    // The same shape as MidiBuffer::addEvent, so callers write to it as they would a buffer
+    void addEvent(const juce::MidiMessage& message, int samplePosition);
+    void addEvent(const juce::uint8* data, int numBytes, int samplePosition);
+
+    // Events added from here until writeTo() are already in sample order. Once per block
+    void beginSortedRun();
+
+    [[nodiscard]] size_t size() const { return events.size(); }
+    [[nodiscard]] bool isEmpty() const { return events.empty(); }
+    void clear();
+
+    // How many bytes a MidiBuffer needs to hold a full queue
+    [[nodiscard]] int getMidiBufferBytes() const;
+
+    // Sort and replace midiOut's contents with everything, then clear the queue. midiOut
+    // should be reserved for getMidiBufferBytes() so writing doesn't allocate
+    void writeTo(juce::MidiBuffer& midiOut);
+
+private:
+    struct Event
+    {
+        int samplePosition;
+        uint32_t order; // Position in the block, breaks ties between events on the same sample
+        uint32_t offset; // Into bytes
+        uint32_t numBytes;
+    };
+
+    std::vector<Event> events;
+    std::vector<juce::uint8> bytes; // Every event's data, in the order they were added
+    static constexpr size_t NO_SORTED_RUN = std::numeric_limits<size_t>::max();
+    size_t sortedRunStart{NO_SORTED_RUN}; // Index of the run's first event
+
+    size_t eventCapacity{0};
+    size_t byteCapacity{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiEventQueue)
+};
+
+} // namespace Sirkus::Core
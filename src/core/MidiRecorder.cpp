@@ -0,0 +1,190 @@
+#include "MidiRecorder.h"
+
+#include "../Constants.h"
+#include "Pattern.h"
+#include "UndoHistory.h"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace Sirkus::Core {
+
+using namespace Sirkus::Constants;
+
+MidiRecorder::MidiRecorder(UndoHistory& undoHistoryToUse)
+    : undoHistory(undoHistoryToUse)
+{
+}
+
+MidiRecorder::~MidiRecorder()
+{
+    stopTimer();
+}
+
+void MidiRecorder::setRecording(const bool shouldRecord)
+{
+    if (shouldRecord == isRecording())
+        return;
+
+    if (shouldRecord)
+    {
+        // Whatever was left over from a previous take doesn't belong to this one
+        drainFifo();
+        heldNotes = {};
+        hasPass = false;
+        recording.store(true, std::memory_order_relaxed);
+        startTimerHz(30);
+    }
+    else
+    {
+        recording.store(false, std::memory_order_relaxed);
+        drainFifo();
+        heldNotes = {};
+        stopTimer();
+    }
+}
+
+void MidiRecorder::setTargetPattern(std::shared_ptr<Pattern> pattern)
+{
+    if (pattern == targetPattern)
+        return;
+
+    targetPattern = std::move(pattern);
+    heldNotes = {};
+    hasPass = false;
+}
+
+void MidiRecorder::captureBlock(const juce::MidiBuffer& midiIn, const BlockTiming& timing)
+{
+    if (!isRecording())
+        return;
+
+    for (const auto metadata : midiIn)
+    {
+        // Parse the raw bytes, building a MidiMessage isn't needed for note data
+        if (metadata.numBytes < 3)
+            continue;
+
+        const auto status = static_cast<uint8_t>(metadata.data[0] & 0xF0);
+        if (status != 0x90 && status != 0x80)
+            continue;
+
+        const auto note = static_cast<uint8_t>(metadata.data[1] & 0x7F);
+        const auto velocity = static_cast<uint8_t>(status == 0x90 ? metadata.data[2] & 0x7F : 0);
+        const auto tick = static_cast<int>(timing.tickAtSample(metadata.samplePosition));
+
+        // A full FIFO drops the event, the message thread has fallen too far behind
+        const auto scope = fifo.write(1);
+        if (scope.blockSize1 > 0)
+            events[static_cast<size_t>(scope.startIndex1)] = CapturedEvent{tick, note, velocity};
+        else if (scope.blockSize2 > 0)
+            events[static_cast<size_t>(scope.startIndex2)] = CapturedEvent{tick, note, velocity};
+    }
+}
+
+void MidiRecorder::timerCallback()
+{
+    drainFifo();
+}
+
+void MidiRecorder::drainFifo()
+{
+    const int numReady = fifo.getNumReady();
+    if (numReady <= 0)
+        return;
+
+    const auto scope = fifo.read(numReady);
+    const auto handleEvent = [this](const CapturedEvent& event) {
+        auto& held = heldNotes[event.note];
+        if (event.velocity > 0)
+        {
+            held = HeldNote{true, event.tick, event.velocity};
+            return;
+        }
+
+        if (!held.active)
+            return;
+
+        held.active = false;
+        writeNote(held.tick, event.note, held.velocity, event.tick - held.tick);
+    };
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        handleEvent(events[static_cast<size_t>(scope.startIndex1 + i)]);
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        handleEvent(events[static_cast<size_t>(scope.startIndex2 + i)]);
+
+    if (writing)
+    {
+        undoHistory.endBackgroundEdit();
+        writing = false;
+    }
+}
+
+void MidiRecorder::writeNote(const int tick, const uint8_t note, const uint8_t velocity, const int lengthTicks)
+{
+    if (targetPattern == nullptr)
+        return;
+
+    auto& pattern = *targetPattern;
+    const int gridSpacing = stepIntervalToTicks(pattern.getStepInterval());
+    const int length = static_cast<int>(pattern.getLength());
+    const int patternLengthTicks = gridSpacing * length;
+    if (gridSpacing <= 0 || patternLengthTicks <= 0)
+        return;
+
+    // Position within the pattern and the nearest grid line
+    const int localTick = ((tick % patternLengthTicks) + patternLengthTicks) % patternLengthTicks;
+    const int gridIndex = (localTick + gridSpacing / 2) / gridSpacing;
+    const int residual = localTick - gridIndex * gridSpacing;
+
+    // Strength pulls the note towards the grid, whatever is left stays as a timing offset
+    const float strength = quantizeEnabled ? quantizeStrength / 100.0f : 0.0f;
+    const int keptOffset = static_cast<int>(std::lround(static_cast<float>(residual) * (1.0f - strength)));
+
+    // Notes snapped forward past the last step belong to the next pass
+    const int gridAlignedTick = tick - residual;
+    const int pass = gridAlignedTick >= 0
+        ? gridAlignedTick / patternLengthTicks
+        : -((-gridAlignedTick + patternLengthTicks - 1) / patternLengthTicks);
+
+    // The pass's transaction carries on from the last drain unless something else started one
+    const bool newPass = !hasPass || pass != currentPass;
+    undoHistory.beginBackgroundEdit("Record pass", newPass);
+    currentPass = pass;
+    hasPass = true;
+    writing = true;
+
+    const auto stepIndex = static_cast<size_t>(gridIndex % length);
+    pattern.setStepNote(stepIndex, note);
+    pattern.setStepVelocity(stepIndex, velocity);
+    pattern.setStepNoteLength(stepIndex, nearestNoteLength(lengthTicks));
+    pattern.setStepOffset(stepIndex, static_cast<float>(keptOffset) / static_cast<float>(PPQN));
+    pattern.setStepEnabled(stepIndex, true);
+}
+
+TimeDivision MidiRecorder::nearestNoteLength(const int lengthTicks)
+{
+    static constexpr std::array<TimeDivision, 10> lengths = {
+        TimeDivision::HundredTwentyEighthNote,
+        TimeDivision::SixtyFourthNote,
+        TimeDivision::ThirtySecondNote,
+        TimeDivision::SixteenthNote,
+        TimeDivision::EighthNote,
+        TimeDivision::QuarterNote,
+        TimeDivision::HalfNote,
+        TimeDivision::WholeNote,
+        TimeDivision::TwoBars,
+        TimeDivision::FourBars};
+
+    TimeDivision nearest = lengths.front();
+    for (const auto candidate : lengths)
+    {
+        if (std::abs(candidate - lengthTicks) < std::abs(nearest - lengthTicks))
+            nearest = candidate;
+    }
+    return nearest;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "BlockTiming.h"
+#include "Types.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace Sirkus::Core {
+
+class Pattern;
+class UndoHistory;
+
+/*
+Records incoming notes into a Pattern.
+
+The audio thread only stamps note-on/off messages with their absolute tick and pushes
+them into a fixed-size single-producer/single-consumer FIFO. A timer on the message
+thread drains the FIFO, pairs note-ons with their note-offs, quantizes them to the
+pattern grid and writes them into the target pattern. Each pass through the pattern
+becomes one undo transaction of its own, which edits made in the UI during the pass
+don't join.
+*/
+class MidiRecorder final : private juce::Timer
+{
+public:
+    static constexpr int FIFO_SIZE = 1024;
+
+    explicit MidiRecorder(UndoHistory& undoHistoryToUse);
+    ~MidiRecorder() override;
+
+    // Message thread
+    void setRecording(bool shouldRecord);
+    // Shared, so a pattern the track lets go of while armed stays alive for the notes still to write
+    void setTargetPattern(std::shared_ptr<Pattern> pattern);
+    void setQuantizeEnabled(bool enabled) { quantizeEnabled = enabled; }
+    void setQuantizeStrength(float percent) { quantizeStrength = juce::jlimit(0.0f, 100.0f, percent); }
+
+    [[nodiscard]] Pattern* getTargetPattern() const { return targetPattern.get(); }
+    [[nodiscard]] bool isQuantizeEnabled() const { return quantizeEnabled; }
+    [[nodiscard]] float getQuantizeStrength() const { return quantizeStrength; }
+
+    // Any thread
+    [[nodiscard]] bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    // Audio thread: stamp the block's notes with their absolute tick and queue them
+    void captureBlock(const juce::MidiBuffer& midiIn, const BlockTiming& timing);
+
+private:
+    struct CapturedEvent
+    {
+        int tick;
+        uint8_t note;
+        uint8_t velocity; // 0 for note-off
+    };
+
+    struct HeldNote
+    {
+        bool active;
+        int tick;
+        uint8_t velocity;
+    };
+
+    void timerCallback() override;
+    void drainFifo();
+    void writeNote(int tick, uint8_t note, uint8_t velocity, int lengthTicks);
+
+    static TimeDivision nearestNoteLength(int lengthTicks);
+
+    UndoHistory& undoHistory;
+
+    juce::AbstractFifo fifo{FIFO_SIZE};
+    std::array<CapturedEvent, FIFO_SIZE> events{};
+    std::atomic<bool> recording{false};
+
+    // Message thread state
+    std::shared_ptr<Pattern> targetPattern;
+    std::array<HeldNote, 128> heldNotes{};
+    bool quantizeEnabled{true};
+    float quantizeStrength{100.0f};
+    bool hasPass{false};
+    int currentPass{0};
+    bool writing{false}; // Inside a background edit
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiRecorder)
+};
+
+} // namespace Sirkus::Core
@@ -0,0 +1,73 @@
+#include "MidiThru.h"
+
+#include <algorithm>
+#include <array>
+
+namespace Sirkus::Core {
+
+MidiThru::MidiThru() = default;
+
+void MidiThru::setChannelEnabled(const int channel, const bool shouldPass)
+{
+    if (channel < 1 || channel > 16)
+        return;
+
+    const auto bit = static_cast<uint16_t>(1u << (channel - 1));
+    const uint16_t mask = getChannelMask();
+    setChannelMask(shouldPass ? static_cast<uint16_t>(mask | bit) : static_cast<uint16_t>(mask & ~bit));
+}
+
+bool MidiThru::isChannelEnabled(const int channel) const
+{
+    if (channel < 1 || channel > 16)
+        return false;
+
+    return (getChannelMask() & (1u << (channel - 1))) != 0;
+}
+
+void MidiThru::process(const juce::MidiBuffer& midiIn, MidiEventQueue& midiOut, const int targetChannel)
+{
+    if (!isEnabled() || midiIn.isEmpty())
+        return;
+
+    const uint16_t mask = getChannelMask();
+    const int channel = isRechannelizing() ? targetChannel : 0;
+
+    // The input is already in sample order, so the queue merges it rather than sorting it
+    midiOut.beginSortedRun();
+    for (const auto metadata : midiIn)
+        addInputEvent(metadata, mask, channel, midiOut);
+}
+
+void MidiThru::addInputEvent(
+    const juce::MidiMessageMetadata& metadata,
+    const uint16_t mask,
+    const int targetChannel,
+    MidiEventQueue& midiOut)
+{
+    const juce::uint8 status = metadata.numBytes > 0 ? metadata.data[0] : 0;
+
+    // System messages have no channel and always pass
+    if (status < 0x80 || status >= 0xF0)
+    {
+        midiOut.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+        return;
+    }
+
+    const int channel = (status & 0x0F) + 1;
+    if ((mask & (1u << (channel - 1))) == 0)
+        return;
+
+    if (targetChannel < 1 || targetChannel > 16 || metadata.numBytes > 3)
+    {
+        midiOut.addEvent(metadata.data, metadata.numBytes, metadata.samplePosition);
+        return;
+    }
+
+    std::array<juce::uint8, 3> bytes{};
+    std::copy_n(metadata.data, metadata.numBytes, bytes.begin());
+    bytes[0] = static_cast<juce::uint8>((status & 0xF0) | (targetChannel - 1));
+    midiOut.addEvent(bytes.data(), metadata.numBytes, metadata.samplePosition);
+}
+
+} // namespace Sirkus::Core
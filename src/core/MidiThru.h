@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "MidiEventQueue.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Passes the host's incoming MIDI through to the output, merged in sample order with the
+events the sequencer generated for the same block.
+
+The incoming events are added to the block's event queue after the generated ones, as a
+run already in sample order. The queue merges the two runs in one linear pass and
+generated events win ties. Incoming channel messages
+can be filtered per channel and moved onto a target channel. Settings are atomics so
+the message thread can change them while the audio thread is running.
+*/
+class MidiThru
+{
+public:
+    static constexpr uint16_t ALL_CHANNELS = 0xFFFF;
+
+    MidiThru();
+
+    // Message thread
+    void setEnabled(bool shouldBeEnabled) { enabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+    void setChannelMask(uint16_t mask) { channelMask.store(mask, std::memory_order_relaxed); }
+    void setChannelEnabled(int channel, bool shouldPass);
+    void setRechannelize(bool shouldRechannelize) { rechannelize.store(shouldRechannelize, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint16_t getChannelMask() const { return channelMask.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool isChannelEnabled(int channel) const;
+    [[nodiscard]] bool isRechannelizing() const { return rechannelize.load(std::memory_order_relaxed); }
+
+    // Audio thread, after every other event of the block is generated. targetChannel (1-16) is used when
+    // rechannelizing, 0 leaves channels alone
+    void process(const juce::MidiBuffer& midiIn, MidiEventQueue& midiOut, int targetChannel);
+
+private:
+    static void addInputEvent(
+        const juce::MidiMessageMetadata& metadata,
+        uint16_t mask,
+        int targetChannel,
+        MidiEventQueue& midiOut);
+
+    std::atomic<bool> enabled{false};
+    std::atomic<uint16_t> channelMask{ALL_CHANNELS};
+    std::atomic<bool> rechannelize{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiThru)
+};
+
+} // namespace Sirkus::Core
@@ -0,0 +1,187 @@
+#include "Parameters.h"
+
+#include "Scale.h"
+#include "Sequencer.h"
+#include "UndoHistory.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Sirkus::Core {
+
+namespace {
+constexpr int PARAMETER_VERSION = 1;
+
+juce::StringArray getScaleNames()
+{
+    // Custom scales are edited note by note, so they aren't offered to the host
+    return {
+        "Major",
+        "Minor",
+        "Harmonic Minor",
+        "Melodic Minor",
+        "Dorian",
+        "Phrygian",
+        "Lydian",
+        "Mixolydian",
+        "Locrian",
+        "Pentatonic Major",
+        "Pentatonic Minor",
+        "Blues",
+        "Chromatic"};
+}
+} // namespace
+
+Parameters::Parameters(juce::AudioProcessor& processor, Sequencer& sequencerToUse, UndoHistory& undoHistoryToUse)
+    : sequencer(sequencerToUse)
+      , undoHistory(undoHistoryToUse)
+{
+    // The processor owns the parameters, these pointers stay valid for its lifetime
+    swing = new juce::AudioParameterFloat(
+        juce::ParameterID{"swing", PARAMETER_VERSION},
+        "Swing",
+        juce::NormalisableRange<float>(0.0f, MAX_SWING),
+        juce::jlimit(0.0f, MAX_SWING, sequencer.getSwingAmount()));
+    processor.addParameter(swing);
+
+    const auto scaleNames = getScaleNames();
+    const int currentScale = static_cast<int>(sequencer.getScaleType());
+    scaleType = new juce::AudioParameterChoice(
+        juce::ParameterID{"scaleType", PARAMETER_VERSION},
+        "Scale",
+        scaleNames,
+        currentScale < scaleNames.size() ? currentScale : 0);
+    processor.addParameter(scaleType);
+
+    scaleRoot = new juce::AudioParameterInt(
+        juce::ParameterID{"scaleRoot", PARAMETER_VERSION},
+        "Scale Root",
+        0,
+        11,
+        sequencer.getScaleRoot());
+    processor.addParameter(scaleRoot);
+
+    for (size_t index = 0; index < MAX_TRACKS; ++index)
+    {
+        const juce::String prefix = "track" + juce::String(static_cast<int>(index + 1));
+        const juce::String name = "Track " + juce::String(static_cast<int>(index + 1));
+
+        trackMute[index] = new juce::AudioParameterBool(
+            juce::ParameterID{prefix + "Mute", PARAMETER_VERSION},
+            name + " Mute",
+            false);
+        processor.addParameter(trackMute[index]);
+
+        trackProbability[index] = new juce::AudioParameterFloat(
+            juce::ParameterID{prefix + "Probability", PARAMETER_VERSION},
+            name + " Probability",
+            juce::NormalisableRange<float>(0.0f, 1.0f),
+            1.0f);
+        processor.addParameter(trackProbability[index]);
+
+        trackTranspose[index] = new juce::AudioParameterInt(
+            juce::ParameterID{prefix + "Transpose", PARAMETER_VERSION},
+            name + " Transpose",
+            -MAX_TRANSPOSE,
+            MAX_TRANSPOSE,
+            0);
+        processor.addParameter(trackTranspose[index]);
+    }
+
+    // Only the parameters that mirror the model need to hear about changes
+    swing->addListener(this);
+    scaleType->addListener(this);
+    scaleRoot->addListener(this);
+    sequencer.getChangeDispatcher().addSubscriber(this);
+    startTimer(POLL_INTERVAL_MS);
+}
+
+Parameters::~Parameters()
+{
+    stopTimer();
+    sequencer.getChangeDispatcher().removeSubscriber(this);
+    swing->removeListener(this);
+    scaleType->removeListener(this);
+    scaleRoot->removeListener(this);
+}
+
+size_t Parameters::getTrackIndex(const uint32_t trackId)
+{
+    const size_t index = Sequencer::TrackSlots::getSlotIndex(trackId);
+    return index < MAX_TRACKS ? index : MAX_TRACKS;
+}
+
+bool Parameters::isTrackMuted(const uint32_t trackId) const
+{
+    const size_t index = getTrackIndex(trackId);
+    return index < MAX_TRACKS && trackMute[index]->get();
+}
+
+float Parameters::getTrackProbability(const uint32_t trackId) const
+{
+    const size_t index = getTrackIndex(trackId);
+    return index < MAX_TRACKS ? trackProbability[index]->get() : 1.0f;
+}
+
+int Parameters::getTrackTranspose(const uint32_t trackId) const
+{
+    const size_t index = getTrackIndex(trackId);
+    return index < MAX_TRACKS ? trackTranspose[index]->get() : 0;
+}
+
+void Parameters::parameterValueChanged(const int parameterIndex, const float newValue)
+{
+    // Called on whichever thread the host automates from, often the audio thread. Only
+    // the flags are set here, the timer picks them up
+    juce::ignoreUnused(newValue);
+
+    if (parameterIndex == swing->getParameterIndex())
+        swingChanged.store(true, std::memory_order_release);
+    else
+        scaleChanged.store(true, std::memory_order_release);
+}
+
+void Parameters::parameterGestureChanged(const int parameterIndex, const bool gestureIsStarting)
+{
+    juce::ignoreUnused(parameterIndex, gestureIsStarting);
+}
+
+void Parameters::modelChanged(const std::vector<ChangeEvent>& changes)
+{
+    // Swing edited in the model, let the host know so its automation lane follows
+    const auto swingChangedInModel = [](const ChangeEvent& change) {
+        return change.node == ChangeEvent::Node::Sequencer && change.property == Sequencer::Schema::swingAmount.index;
+    };
+    // A host value still on its way to the model wins over the model's older one
+    if (swingChanged.load(std::memory_order_acquire) || std::ranges::none_of(changes, swingChangedInModel))
+        return;
+
+    const float modelSwing = juce::jlimit(0.0f, MAX_SWING, sequencer.getSwingAmount());
+    if (std::abs(modelSwing - swing->get()) > 1.0e-6f)
+        swing->setValueNotifyingHost(swing->convertTo0to1(modelSwing));
+}
+
+void Parameters::timerCallback()
+{
+    // The model's echo of these edits arrives in a later batch and finds the values already agree
+    if (swingChanged.exchange(false, std::memory_order_acquire))
+    {
+        if (std::abs(sequencer.getSwingAmount() - swing->get()) > 1.0e-6f)
+        {
+            // Not part of whatever the user last did, which undo would otherwise take it with
+            undoHistory.beginBackgroundEdit("Swing automation");
+            sequencer.setSwingAmount(swing->get());
+            undoHistory.endBackgroundEdit();
+        }
+    }
+
+    if (scaleChanged.exchange(false, std::memory_order_acquire))
+    {
+        const auto type = static_cast<Scale::Type>(scaleType->getIndex());
+        const auto root = static_cast<uint8_t>(scaleRoot->get());
+        if (type != sequencer.getScaleType() || root != sequencer.getScaleRoot())
+            sequencer.setScale(type, root);
+    }
+}
+
+} // namespace Sirkus::Core
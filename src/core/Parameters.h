@@ -0,0 +1,82 @@
+#pragma once
+
+#include "../Constants.h"
+#include "../JuceHeader.h"
+#include "ChangeDispatcher.h"
+
+#include <array>
+#include <atomic>
+
+namespace Sirkus::Core {
+
+class Sequencer;
+class UndoHistory;
+
+/*
+The parameters the host can automate: swing, the global scale, and mute, probability
+and transpose for each track.
+
+Each track has its own mute, probability and transpose for as long as it exists, whatever
+slot it plays in, so removing a track doesn't hand its automation to the tracks after it.
+They are found by the track id's slot map index, which is below MAX_TRACKS while at most
+MAX_TRACKS tracks exist. A later track reuses a removed track's parameters.
+
+Values live in the JUCE parameter objects, which store them atomically, and the engine
+reads them once per block. JUCE's parameter API gives no sample offsets for automation,
+so the start of the block is the only change point a host can give: swing applies from
+the block's first tick. A mute request is then scheduled like any other, on the next
+boundary of the mute quantization, which can fall anywhere inside the block.
+
+Swing and the scale also belong to the sequencer's model. Hosts call parameterValueChanged
+from whichever thread they automate on, often the audio thread, so it only sets a flag.
+A timer on the message thread polls the flags and copies the new values into the model,
+so nothing on the audio thread posts messages or touches the ValueTree. Edits to the
+model's swing come back through the sequencer's ChangeDispatcher and go on to the host.
+Automation's swing edits are background edits, so undo never mixes them into the user's.
+*/
+class Parameters final
+    : private juce::AudioProcessorParameter::Listener
+      , private ChangeDispatcher::Subscriber
+      , private juce::Timer
+{
+public:
+    static constexpr float MAX_SWING = 0.5f; // In quarter notes, like the model's swing amount
+    static constexpr int MAX_TRANSPOSE = 24;
+
+    Parameters(juce::AudioProcessor& processor, Sequencer& sequencer, UndoHistory& undoHistory);
+    ~Parameters() override;
+
+    // Audio thread. Track parameters are looked up by track id
+    [[nodiscard]] float getSwing() const { return swing->get(); }
+    [[nodiscard]] bool isTrackMuted(uint32_t trackId) const;
+    [[nodiscard]] float getTrackProbability(uint32_t trackId) const;
+    [[nodiscard]] int getTrackTranspose(uint32_t trackId) const;
+
+private:
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+    void modelChanged(const std::vector<ChangeEvent>& changes) override;
+    void timerCallback() override;
+
+    static size_t getTrackIndex(uint32_t trackId); // MAX_TRACKS for ids that have none
+
+    static constexpr int POLL_INTERVAL_MS = 30;
+
+    Sequencer& sequencer;
+    UndoHistory& undoHistory;
+
+    juce::AudioParameterFloat* swing{nullptr};
+    juce::AudioParameterChoice* scaleType{nullptr};
+    juce::AudioParameterInt* scaleRoot{nullptr};
+    std::array<juce::AudioParameterBool*, MAX_TRACKS> trackMute{};
+    std::array<juce::AudioParameterFloat*, MAX_TRACKS> trackProbability{};
+    std::array<juce::AudioParameterInt*, MAX_TRACKS> trackTranspose{};
+
+    // Set wherever the host changed something, cleared on the message thread
+    std::atomic<bool> swingChanged{false};
+    std::atomic<bool> scaleChanged{false};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Parameters)
+};
+
+} // namespace Sirkus::Core
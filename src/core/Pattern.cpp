@@ -16,6 +16,8 @@
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Sirkus::Core {
 
@@ -23,21 +25,66 @@ using namespace Sirkus::Constants;
 
 Pattern::Pattern(ValueTree parentState, UndoManager& undoManagerToUse)
     : ValueTreeObject(parentState, ID::pattern, undoManagerToUse)
-      , props{}
 {
     // Initialize default properties
     setLength(16);
     setSwingAmount(0.0f);
     setStepInterval(TimeDivision::SixteenthNote);
 
-    // Initialize steps
-    // To make life simpler, we create the maximum number of steps a pattern can have
-    // It expected that this won't ever be a huuuge number so this is fine
-    for (size_t i = 0; i < MAX_STEPS; ++i)
+    // Steps are created a page at a time when first used, so a new pattern starts with
+    // none and an empty trigger map
+    rebuildStepTiming();
+}
+
+Pattern::Pattern(ValueTree parentState, UndoManager& undoManagerToUse, const Pattern& source)
+    : ValueTreeObject(source.state.createCopy(), undoManagerToUse)
+{
+    // A copy isn't an edit either, the new tree is added without undo like new steps are
+    parentState.addChild(state, -1, nullptr);
+
+    // The copied tree already holds the source's pages of steps, each step tagged with its index
+    std::vector<ValueTree> stepTrees(MAX_STEPS);
+    for (int child = 0; child < state.getNumChildren(); ++child)
     {
-        ensureStepExists(i);
-        initializeStepTiming(i);
+        const auto stepTree = state.getChild(child);
+        const int index = stepTree.getProperty(ID::Step::stepIndex, -1);
+        if (juce::isPositiveAndBelow(index, MAX_STEPS))
+            stepTrees[static_cast<size_t>(index)] = stepTree;
+    }
+
+    uint32_t pages = 0;
+    for (size_t page = 0; page < NUM_PAGES; ++page)
+    {
+        if (!stepTrees[page * STEPS_PER_PAGE].isValid())
+            continue;
+
+        auto newPage = std::make_unique<StepPage>();
+        newPage->reserve(STEPS_PER_PAGE);
+        for (size_t i = 0; i < STEPS_PER_PAGE; ++i)
+            newPage->emplace_back(stepTrees[page * STEPS_PER_PAGE + i], undoManager, true);
+
+        stepPages[page] = std::move(newPage);
+        pages |= 1u << page;
     }
+    createdPages.store(pages, std::memory_order_release);
+
+    groove = source.groove;
+    rebuildStepTiming();
+}
+
+void Pattern::moveTree(ValueTree newParent)
+{
+    // Like creating steps, where the pattern's tree lives isn't an edit
+    if (auto parent = state.getParent(); parent.isValid())
+        parent.removeChild(state, nullptr);
+
+    if (newParent.isValid())
+        newParent.addChild(state, -1, nullptr);
+}
+
+bool Pattern::isChildOf(const ValueTree& tree) const
+{
+    return state.getParent() == tree;
 }
 
 void Pattern::setLength(size_t newLength)
@@ -70,17 +117,61 @@ TimeDivision Pattern::getStepInterval() const
     return getProperty(props.stepInterval);
 }
 
-void Pattern::ensureStepExists(const size_t stepIndex)
+void Pattern::setGroove(const Groove& newGroove)
+{
+    // Stored as a string so it persists and undoes like any other property. The change
+    // comes back through handleChange(), which recompiles this pattern's triggers
+    setProperty(props.groove, newGroove.toString());
+}
+
+const Groove& Pattern::getGroove() const
+{
+    return groove;
+}
+
+Step& Pattern::ensureStepExists(const size_t stepIndex) const
 {
     if (stepIndex >= MAX_STEPS)
         throw std::out_of_range("Step index out of range: " + std::to_string(stepIndex));
 
-    if (!state.getChild(static_cast<int>(stepIndex)).isValid())
+    const size_t page = stepIndex / STEPS_PER_PAGE;
+    if (!hasPage(page))
     {
-        // Creating a new step ensures the values are added to
-        // the ValueTree
-        steps[stepIndex] = std::make_unique<Step>(state, undoManager, static_cast<int>(stepIndex));
+        // Creating steps isn't an edit, so they are added without undo and undoing can't remove
+        // them. The index is set before the step joins the tree, so nothing hears about it
+        auto newPage = std::make_unique<StepPage>();
+        newPage->reserve(STEPS_PER_PAGE);
+        for (size_t i = 0; i < STEPS_PER_PAGE; ++i)
+        {
+            ValueTree stepState(ID::step);
+            stepState.setProperty(ID::Step::stepIndex, static_cast<int>(page * STEPS_PER_PAGE + i), nullptr);
+            ValueTree(state).addChild(stepState, -1, nullptr);
+            newPage->emplace_back(stepState, undoManager, true);
+        }
+
+        stepPages[page] = std::move(newPage);
+        createdPages.fetch_or(1u << page, std::memory_order_release);
     }
+
+    return stepAt(stepIndex);
+}
+
+bool Pattern::hasPage(const size_t page) const
+{
+    return (createdPages.load(std::memory_order_acquire) & (1u << page)) != 0;
+}
+
+Step& Pattern::stepAt(const size_t stepIndex) const
+{
+    return (*stepPages[stepIndex / STEPS_PER_PAGE])[stepIndex % STEPS_PER_PAGE];
+}
+
+const Step* Pattern::findStep(const size_t stepIndex) const
+{
+    if (stepIndex >= MAX_STEPS || !hasPage(stepIndex / STEPS_PER_PAGE))
+        return nullptr;
+
+    return &stepAt(stepIndex);
 }
 
 Step& Pattern::getStep(const size_t stepIndex) const
@@ -90,12 +181,13 @@ Step& Pattern::getStep(const size_t stepIndex) const
             "Step index out of range: " + std::to_string(stepIndex) + ". Pattern length: " +
             std::to_string(getLength()));
 
-    return *steps[stepIndex];
+    return ensureStepExists(stepIndex);
 }
 
 bool Pattern::isStepEnabled(const size_t stepIndex) const
 {
-    return steps[stepIndex]->isEnabled();
+    const Step* step = findStep(stepIndex);
+    return step != nullptr && step->isEnabled();
 }
 
 void Pattern::setStepEnabled(const size_t stepIndex, const bool enabled)
@@ -103,7 +195,7 @@ void Pattern::setStepEnabled(const size_t stepIndex, const bool enabled)
     // NOLINTNEXTLINE
     DBG("Pattern::setStepEnabled: " << stepIndex << " -> " << std::to_string(enabled));
 
-    steps[stepIndex]->setEnabled(enabled);
+    ensureStepExists(stepIndex).setEnabled(enabled);
 }
 
 void Pattern::setStepNote(const size_t stepIndex, uint8_t note) const
@@ -111,42 +203,43 @@ void Pattern::setStepNote(const size_t stepIndex, uint8_t note) const
     // NOLINTNEXTLINE
     DBG("Pattern::setStepNote: " << stepIndex << " -> " << std::to_string(note));
 
-    steps[stepIndex]->setNote(note);
+    ensureStepExists(stepIndex).setNote(note);
 }
 
 void Pattern::setStepVelocity(const size_t stepIndex, uint8_t velocity) const
 {
-    steps[stepIndex]->setVelocity(velocity);
+    ensureStepExists(stepIndex).setVelocity(velocity);
 }
 
 void Pattern::setStepProbability(const size_t stepIndex, float probability) const
 {
-    steps[stepIndex]->setProbability(probability);
+    ensureStepExists(stepIndex).setProbability(probability);
 }
 
 void Pattern::setStepOffset(const size_t stepIndex, const float offset)
 {
-    steps[stepIndex]->setTimingOffset(offset);
+    ensureStepExists(stepIndex).setTimingOffset(offset);
 }
 
 void Pattern::setStepSwingAffected(const size_t stepIndex, const bool affected)
 {
-    steps[stepIndex]->setAffectedBySwing(affected);
+    ensureStepExists(stepIndex).setAffectedBySwing(affected);
 }
 
 void Pattern::setStepTrackId(const size_t stepIndex, const uint32_t trackId)
 {
-    steps[stepIndex]->setTrackId(trackId);
+    ensureStepExists(stepIndex).setTrackId(trackId);
 }
 
 void Pattern::setStepNoteLength(const size_t stepIndex, TimeDivision length)
 {
-    steps[stepIndex]->setNoteLength(length);
+    ensureStepExists(stepIndex).setNoteLength(length);
 }
 
 int Pattern::getStepStartTick(const size_t stepIndex) const
 {
-    return steps[stepIndex]->getTriggerTick();
+    const Step* step = findStep(stepIndex);
+    return step != nullptr ? step->getTriggerTick() : 0;
 }
 
 int Pattern::getStepEndTick(const size_t stepIndex) const
@@ -167,7 +260,8 @@ int Pattern::getStepEndTick(const size_t stepIndex) const
 
 int Pattern::calculateStepTick(size_t stepIndex) const
 {
-    if (stepIndex >= MAX_STEPS)
+    // Only called for steps that exist
+    if (findStep(stepIndex) == nullptr)
         return 0;
 
     // Calculate base tick using step interval
@@ -176,78 +270,158 @@ int Pattern::calculateStepTick(size_t stepIndex) const
     int finalTick = baseTick;
 
     // Apply swing if applicable
-    if (steps[stepIndex]->isAffectedBySwing() && (stepIndex % 2) != 0)
+    if (isStepAffectedBySwing(stepIndex))
     {
         finalTick += static_cast<int>(PPQN * getSwingAmount());
     }
 
+    // Groove moves the same steps swing does, by whatever its grid position calls for
+    const Step& step = stepAt(stepIndex);
+    if (step.isAffectedBySwing())
+    {
+        finalTick += groove.getTimingOffset(baseTick);
+    }
+
     // Apply micro-timing offset
-    const float offset = steps[stepIndex]->getTimingOffset();
+    const float offset = step.getTimingOffset();
     const int tickOffset = static_cast<int>(PPQN * offset);
 
     // Handle wrapping for negative offsets
     const int gridLength = static_cast<int>(getLength());
     const int patternLengthTicks = gridLength * gridSpacing;
+    if (patternLengthTicks <= 0)
+        return 0;
+
+    return ((finalTick + tickOffset) % patternLengthTicks + patternLengthTicks) % patternLengthTicks;
+}
 
-    return (finalTick + tickOffset + patternLengthTicks) % patternLengthTicks;
+bool Pattern::isStepAffectedBySwing(const size_t stepIndex) const
+{
+    return stepAt(stepIndex).isAffectedBySwing() && (stepIndex % 2) != 0;
 }
 
-void Pattern::updateStepTiming(const size_t stepIndex, bool acquireLock)
+int Pattern::calculateStepVelocityOffset(const size_t stepIndex) const
 {
     if (stepIndex >= MAX_STEPS)
-        return;
+        return 0;
+
+    return groove.getVelocityOffset(static_cast<int>(stepIndex) * getStepInterval());
+}
 
-    std::unique_ptr<std::lock_guard<std::mutex>> lock;
-    if (acquireLock)
+void Pattern::handleChange(const ChangeEvent& change)
+{
+    if (change.node == ChangeEvent::Node::Pattern)
     {
-        lock = std::make_unique<std::lock_guard<std::mutex>>(updateMutex);
+        if (change.property == Schema::groove.index)
+        {
+            groove = Groove::fromString(getProperty(props.groove));
+            rebuildPending = true;
+        }
+
+        // Anything that moves the grid moves every step
+        if (change.property == Schema::length.index || change.property == Schema::swingAmount.index ||
+            change.property == Schema::stepInterval.index)
+        {
+            rebuildPending = true;
+        }
+        return;
     }
 
-    size_t current = this->activeBuffer.load(std::memory_order_acquire);
-    size_t inactive = 1 - current;
+    if (change.node != ChangeEvent::Node::Step || change.step >= MAX_STEPS)
+        return;
 
-    // Work on inactive buffer
-    auto& workingBuffer = triggerBuffers[inactive];
-    // Copy maps from current buffer
-    workingBuffer.tickToStep = triggerBuffers[current].tickToStep;
-    workingBuffer.stepToTick = triggerBuffers[current].stepToTick;
+    // The trigger table holds a copy of what the engine plays, so anything but the unused
+    // trigger tick and track id recompiles the step
+    if (change.property != Step::Schema::triggerTick.index && change.property != Step::Schema::trackId.index)
+    {
+        stepsPendingUpdate.set(change.step);
+    }
+}
+
+bool Pattern::commitChanges()
+{
+    const bool changed = rebuildPending || stepsPendingUpdate.any();
 
-    if (isStepEnabled(stepIndex))
+    // A single step edit patches a copy of the trigger map, anything more is cheaper to
+    // recompile in one pass
+    if (rebuildPending || stepsPendingUpdate.count() > 1)
     {
-        int finalTick = calculateStepTick(stepIndex);
-        workingBuffer.addStep(finalTick, stepIndex);
+        rebuildStepTiming();
     }
-    else
+    else if (stepsPendingUpdate.any())
     {
-        workingBuffer.removeStep(stepIndex);
+        for (size_t i = 0; i < MAX_STEPS; ++i)
+        {
+            if (stepsPendingUpdate.test(i))
+                updateStepTiming(i);
+        }
     }
 
-    // Verify and swap
-    assert(workingBuffer.verifyIntegrity());
-    workingBuffer.dirty.store(true, std::memory_order_release);
-    this->activeBuffer.store(inactive, std::memory_order_release);
+    rebuildPending = false;
+    stepsPendingUpdate.reset();
+    return changed;
 }
 
-void Pattern::initializeStepTiming(const size_t stepIndex)
+void Pattern::rebuildStepTiming()
 {
-    if (stepIndex >= MAX_STEPS)
+    // Start from scratch, every tick may have moved
+    auto compiled = std::make_shared<TriggerBuffer>();
+    compiled->cycleTicks = static_cast<int>(getLength()) * getStepInterval();
+    compiled->stepTicks = getStepInterval();
+    compiled->swingTicks = static_cast<int>(PPQN * getSwingAmount());
+
+    // Steps on pages that don't exist have never been enabled
+    const size_t length = std::min(getLength(), static_cast<size_t>(MAX_STEPS));
+    std::vector<std::pair<int, size_t>> enabled;
+    for (size_t page = 0; page * STEPS_PER_PAGE < length; ++page)
+    {
+        if (!hasPage(page))
+            continue;
+
+        for (size_t i = page * STEPS_PER_PAGE; i < std::min(length, (page + 1) * STEPS_PER_PAGE); ++i)
+        {
+            if (isStepEnabled(i))
+                enabled.emplace_back(calculateStepTick(i), i);
+        }
+    }
+
+    // Sorted once here rather than inserted one at a time
+    std::stable_sort(enabled.begin(), enabled.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [tick, i] : enabled)
+        compiled->append(tick, i, stepAt(i).getData(), calculateStepVelocityOffset(i), isStepAffectedBySwing(i));
+
+    assert(compiled->verifyIntegrity());
+    triggers = std::move(compiled);
+}
+
+void Pattern::updateStepTiming(const size_t stepIndex)
+{
+    if (findStep(stepIndex) == nullptr)
         return;
 
-    if (isStepEnabled(stepIndex))
+    // Published buffers are never changed, the edit goes into a copy
+    auto compiled = std::make_shared<TriggerBuffer>(*triggers);
+    if (stepIndex < getLength() && isStepEnabled(stepIndex))
+    {
+        compiled->addStep(
+            calculateStepTick(stepIndex),
+            stepIndex,
+            stepAt(stepIndex).getData(),
+            calculateStepVelocityOffset(stepIndex),
+            isStepAffectedBySwing(stepIndex));
+    }
+    else
     {
-        int finalTick = calculateStepTick(stepIndex);
-        triggerBuffers[0].addStep(finalTick, stepIndex);
+        compiled->removeStep(stepIndex);
     }
 
-    // Mark as initialized
-    triggerBuffers[0].dirty.store(true, std::memory_order_release);
-    // Set buffer 0 as active
-    this->activeBuffer.store(0, std::memory_order_release);
+    assert(compiled->verifyIntegrity());
+    triggers = std::move(compiled);
 }
 
-const std::map<int, size_t>& Pattern::getTriggerMap() const
+const std::shared_ptr<const TriggerBuffer>& Pattern::getTriggers() const
 {
-    return triggerBuffers[this->activeBuffer.load(std::memory_order_acquire)].tickToStep;
+    return triggers;
 }
 
 } // namespace Sirkus::Core
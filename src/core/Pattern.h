@@ -3,14 +3,17 @@
 #include "../Constants.h"
 #include "../Identifiers.h"
 #include "../JuceHeader.h"
+#include "ChangeDispatcher.h"
+#include "Groove.h"
 #include "Step.h"
 #include "TriggerBuffer.h"
 #include "Types.h"
 #include "ValueTreeObject.h"
 
+#include <array>
 #include <atomic>
-#include <map>
-#include <mutex>
+#include <bitset>
+#include <memory>
 #include <vector>
 
 namespace Sirkus::Core {
@@ -20,13 +23,33 @@ class Pattern final : public ValueTreeObject
 public:
     Pattern(ValueTree parentState, UndoManager& undoManagerToUse);
 
-    struct Properties
+    // A copy of source's properties and steps, with its own tree under parentState
+    Pattern(ValueTree parentState, UndoManager& undoManagerToUse, const Pattern& source);
+
+    // Linked tracks share one pattern, whose tree sits under one of them. When that track
+    // leaves the link the tree moves to another, or is removed with an invalid parent
+    void moveTree(ValueTree newParent);
+    bool isChildOf(const ValueTree& tree) const;
+
+    struct Schema
     {
-        TypedProperty<int> length{ID::Pattern::length, 16};
-        TypedProperty<float> swingAmount{ID::Pattern::swingAmount, 0.0f};
-        TypedProperty<TimeDivision> stepInterval{ID::Pattern::stepInterval, TimeDivision::SixteenthNote};
+        static constexpr TypedProperty<int> length{ID::Pattern::length, 16, 0};
+        static constexpr TypedProperty<float> swingAmount{ID::Pattern::swingAmount, 0.0f, 1};
+        static constexpr TypedProperty<TimeDivision> stepInterval{
+            ID::Pattern::stepInterval,
+            TimeDivision::SixteenthNote,
+            2};
+        static inline const TypedProperty<juce::String> groove{ID::Pattern::groove, {}, 3};
+        static constexpr size_t NUM_PROPERTIES = 4;
+
+        static int indexOf(const juce::Identifier& id)
+        {
+            return findPropertyIndex(id, length, swingAmount, stepInterval, groove);
+        }
     };
 
+    static constexpr Schema props{};
+
     // Step manipulation
     void setStepEnabled(size_t stepIndex, bool enabled);
     void setStepNote(size_t stepIndex, uint8_t note) const;
@@ -45,31 +68,61 @@ public:
     float getSwingAmount() const;
     TimeDivision getStepInterval() const;
 
-    // Step access
+    // Groove template, compiled into the trigger ticks along with swing. Only steps
+    // affected by swing have their timing moved, velocity applies to every step
+    void setGroove(const Groove& newGroove);
+    const Groove& getGroove() const;
+
+    // Step access. Steps are created a page at a time, when a step on the page is first
+    // used, and a step that hasn't been created yet reads as disabled. findStep() never
+    // creates one
     Step& getStep(size_t stepIndex) const;
+    const Step* findStep(size_t stepIndex) const;
     bool isStepEnabled(size_t stepIndex) const;
 
-    // Trigger map access
-    const std::map<int, size_t>& getTriggerMap() const;
+    // The compiled triggers, replaced rather than changed by each recompile. Message thread:
+    // the engine plays the copy in the Sequencer's published TriggerTable
+    const std::shared_ptr<const TriggerBuffer>& getTriggers() const;
 
     // Get step timing information
     int getStepStartTick(size_t stepIndex) const;
 
     int getStepEndTick(size_t stepIndex) const;
 
-private:
-    std::array<TriggerBuffer, 2> triggerBuffers;
-    std::atomic<size_t> activeBuffer{0};
-    mutable std::mutex updateMutex;
-
-    Properties props;
+    // Keeps the trigger map in sync with step and pattern edits. The sequencer hands over
+    // each batch of changes for this pattern, then commits them in one recompile and
+    // publishes the result if this returns true
+    void handleChange(const ChangeEvent& change);
+    bool commitChanges();
 
-    std::vector<std::unique_ptr<Step>> steps = std::vector<std::unique_ptr<Step>>(MAX_STEPS);
-
-    void updateStepTiming(size_t stepIndex, bool acquireLock = false); // Set acquireLock=true if no lock is held
-    void initializeStepTiming(size_t stepIndex);
+private:
+    std::shared_ptr<const TriggerBuffer> triggers;
+
+    Groove groove;
+
+    // Trigger recompiles waiting for commitChanges()
+    bool rebuildPending{false};
+    std::bitset<MAX_STEPS> stepsPendingUpdate;
+
+    // Only the pages with a step that has been used exist, so a long pattern with a few
+    // steps set holds a page or two. Steps are children of the tree in the order their pages
+    // were created, each with its step index as a property. Pages are never freed, so a
+    // step that has been found stays put while the pattern lives
+    static constexpr size_t NUM_PAGES = MAX_STEPS / STEPS_PER_PAGE;
+    static_assert(MAX_STEPS % STEPS_PER_PAGE == 0, "Steps must fill whole pages");
+    static_assert(NUM_PAGES <= 32, "Created pages are kept in a 32-bit mask");
+    using StepPage = std::vector<Step>;
+    mutable std::array<std::unique_ptr<StepPage>, NUM_PAGES> stepPages;
+    mutable std::atomic<uint32_t> createdPages{0}; // One bit per page in stepPages
+
+    void updateStepTiming(size_t stepIndex);
+    void rebuildStepTiming();
     int calculateStepTick(size_t stepIndex) const;
-    void ensureStepExists(size_t stepIndex);
+    int calculateStepVelocityOffset(size_t stepIndex) const;
+    bool isStepAffectedBySwing(size_t stepIndex) const;
+    Step& ensureStepExists(size_t stepIndex) const;
+    Step& stepAt(size_t stepIndex) const;
+    bool hasPage(size_t page) const;
 
     JUCE_LEAK_DETECTOR(Pattern)
 };
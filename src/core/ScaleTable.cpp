@@ -0,0 +1,59 @@
+#include "ScaleTable.h"
+
+#include "Scale.h"
+
+namespace Sirkus::Core {
+
+ScaleTable ScaleTable::fromPitchClasses(const uint16_t pitchClasses, const uint8_t root)
+{
+    ScaleTable table;
+    table.pitchClasses = pitchClasses & ALL_PITCH_CLASSES;
+    table.root = root % 12;
+
+    const auto inScale = [&table](const int note) {
+        return table.pitchClasses == 0 || (table.pitchClasses & (1u << (note % 12))) != 0;
+    };
+
+    // Nearest scale note at or below, then at or above. Either pass can run off the
+    // end of the MIDI range, in which case the other direction is used
+    int below = -1;
+    for (int note = 0; note < 128; ++note)
+    {
+        if (inScale(note))
+            below = note;
+        table.down[static_cast<size_t>(note)] = static_cast<uint8_t>(below);
+    }
+
+    int above = -1;
+    for (int note = 127; note >= 0; --note)
+    {
+        if (inScale(note))
+            above = note;
+        table.up[static_cast<size_t>(note)] = static_cast<uint8_t>(above);
+    }
+
+    for (size_t note = 0; note < 128; ++note)
+    {
+        if (table.down[note] == 0xFF)
+            table.down[note] = table.up[note];
+        if (table.up[note] == 0xFF)
+            table.up[note] = table.down[note];
+    }
+
+    return table;
+}
+
+ScaleTable ScaleTable::fromScale(const Scale& scale)
+{
+    // Preset scales have the root applied to their degrees already, custom degrees are
+    // intervals from it
+    const int offset = scale.getType() == Scale::Type::Custom ? scale.getRoot() : 0;
+
+    uint16_t mask = 0;
+    for (const auto degree : scale.getDegrees())
+        mask = static_cast<uint16_t>(mask | (1u << ((degree + offset) % 12)));
+
+    return fromPitchClasses(mask, scale.getRoot());
+}
+
+} // namespace Sirkus::Core
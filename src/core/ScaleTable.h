@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#include <array>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+class Scale;
+
+/*
+Precomputed quantization lookups for a set of pitch classes.
+
+Scale works on a vector of degrees and searches it for every note. The engine reads
+from this table instead: it is a plain value, so it can be copied between threads,
+and quantizing a note is a single array lookup.
+*/
+struct ScaleTable
+{
+    static constexpr uint16_t ALL_PITCH_CLASSES = 0x0FFF;
+
+    std::array<uint8_t, 128> up{};
+    std::array<uint8_t, 128> down{};
+    uint16_t pitchClasses{0}; // Bit n set when pitch class n (C = 0) is in the scale
+    uint8_t root{0};
+
+    // An empty pitch class mask leaves every note where it is
+    static ScaleTable fromPitchClasses(uint16_t pitchClasses, uint8_t root);
+    static ScaleTable fromScale(const Scale& scale);
+
+    uint8_t quantizeUp(uint8_t note) const
+    {
+        return up[note & 0x7F];
+    }
+
+    uint8_t quantizeDown(uint8_t note) const
+    {
+        return down[note & 0x7F];
+    }
+
+    // Up or down on the lowest of the random bits
+    uint8_t quantizeRandom(uint8_t note, uint32_t randomBits) const
+    {
+        return (randomBits & 1) != 0 ? quantizeUp(note) : quantizeDown(note);
+    }
+};
+
+} // namespace Sirkus::Core
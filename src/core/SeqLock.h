@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace Sirkus::Core {
+
+/*
+Sequence lock for publishing a small value from one writer thread to any number of
+readers.
+
+The writer never waits: it bumps the sequence to odd, stores the value and bumps it
+back to even. Readers copy the value and retry if the sequence was odd or moved while
+they were copying, so they always come away with one complete store. The value is
+kept in atomic words, so concurrent access is well defined.
+*/
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied word by word");
+
+public:
+    SeqLock()
+    {
+        store(T{});
+    }
+
+    // Writer thread
+    void store(const T& value)
+    {
+        std::array<uint64_t, NUM_WORDS> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < NUM_WORDS; ++i)
+            data[i].store(words[i], std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Any thread
+    [[nodiscard]] T load() const
+    {
+        std::array<uint64_t, NUM_WORDS> words{};
+
+        for (;;)
+        {
+            const uint32_t before = sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0)
+                continue;
+
+            for (size_t i = 0; i < NUM_WORDS; ++i)
+                words[i] = data[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+                break;
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::array<std::atomic<uint64_t>, NUM_WORDS> data{};
+};
+
+} // namespace Sirkus::Core
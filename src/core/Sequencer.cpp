@@ -2,6 +2,7 @@
 
 #include "../Constants.h"
 #include "../JuceHeader.h"
+#include "Parameters.h"
 #include "Pattern.h"
 #include "StepProcessor.h"
 #include "TimingManager.h"
@@ -9,16 +10,21 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <optional>
 #include <string>
 #include <vector>
 
 namespace Sirkus::Core {
 
-Sequencer::Sequencer(ValueTree parentState, UndoManager& undoManagerToUse)
-    : ValueTreeObject(parentState, ID::sequencer, undoManagerToUse)
-      , props{}
+Sequencer::Sequencer(ValueTree parentState, UndoHistory& undoHistoryToUse)
+    : ValueTreeObject(parentState, ID::sequencer, undoHistoryToUse)
+      , undoHistory(undoHistoryToUse)
 {
+    for (size_t index = 0; index < Schema::NUM_PROPERTIES; ++index)
+        applyProperty(index);
+
+    changeDispatcher.addSubscriber(this);
 
     // Load any existing tracks from state tree
     // for (int i = 0; i < state.getNumChildren(); ++i)
@@ -44,15 +50,16 @@ uint32_t Sequencer::createTrack()
 {
     if (getTrackCount() >= MAX_TRACKS)
     {
-        return 0; // Return invalid trackId
+        return INVALID_TRACK_ID;
     }
 
-    const uint32_t trackId = generateTrackId();
+    const uint32_t trackId = tracks.getNextHandle();
     auto track = std::make_unique<Track>(state, undoManager, trackId);
     // Apply global swing to pattern
     Pattern& pattern = track->getCurrentPattern();
     pattern.setSwingAmount(getProperty(props.swingAmount));
-    tracks.push_back(std::move(track));
+    tracks.insert(std::move(track));
+    publishTrackList();
     DBG("Sequencer::createTrack(); trackId=" << std::to_string(trackId));
     DBG("Pattern length: " << std::to_string(tracks.back()->getCurrentPattern().getLength()));
     for (size_t i = 0; i < pattern.getLength(); ++i)
@@ -72,39 +79,118 @@ bool Sequencer::removeTrack(uint32_t trackId)
         return false;
     }
 
-    // Find track with matching ID
-    auto trackTree = state.getChildWithProperty(ID::Track::trackId, static_cast<int>(trackId));
-    if (trackTree.isValid())
+    if (!tracks.contains(trackId))
     {
-        state.removeChild(trackTree, &undoManager);
-        // Remove from tracks vector
-        std::erase_if(
-            tracks,
-            [trackId](std::unique_ptr<Track>& t) {
-                return t->getId() == trackId;
-            });
-        return true;
+        return false;
     }
 
-    return false;
+    if (recordArmedTrackId == trackId)
+        setRecordArmedTrack(std::nullopt);
+
+    // A pattern the track shares stays with the tracks still linked to it. Moving it isn't an
+    // edit, and undoing the removal would bring the track back without a pattern, so then
+    // the removal isn't registered with undo either
+    const bool handedOver = handOverPatternTree(**tracks.find(trackId));
+
+    auto trackTree = state.getChildWithProperty(ID::Track::trackId, static_cast<int>(trackId));
+    if (trackTree.isValid())
+        state.removeChild(trackTree, handedOver ? nullptr : &undoManager);
+
+    // The engine may be playing the track right now, it is deleted once the engine has let go
+    std::vector<std::unique_ptr<Track>> retired;
+    retired.push_back(std::move(*tracks.find(trackId)));
+    tracks.erase(trackId);
+
+    // Slots after the removed track move down
+    publishTrackList(std::move(retired));
+    return true;
 }
 
-Track& Sequencer::getTrack(const uint32_t trackId)
+bool Sequencer::linkPattern(const uint32_t trackId, const uint32_t sourceTrackId)
 {
-    // Try to find the track in our vector
-    for (const auto& track : tracks)
+    auto* track = findTrack(trackId);
+    auto* source = findTrack(sourceTrackId);
+    if (track == nullptr || source == nullptr || track->getSharedPattern() == source->getSharedPattern())
+        return false;
+
+    // The pattern the track held goes, unless other tracks still play it. Linking isn't an
+    // edit, so the pattern can't be brought back by undo
+    if (track->holdsPatternTree() && !handOverPatternTree(*track))
+        track->dropPatternTree();
+
+    track->linkPattern(source->getSharedPattern());
+    patternsChanged(trackId);
+    return true;
+}
+
+bool Sequencer::unlinkPattern(const uint32_t trackId)
+{
+    auto* track = findTrack(trackId);
+    if (track == nullptr || !isPatternLinked(trackId))
+        return false;
+
+    // The copy's tree goes under this track, so the shared tree moves to another first
+    handOverPatternTree(*track);
+    track->unlinkPattern();
+    patternsChanged(trackId);
+    return true;
+}
+
+bool Sequencer::isPatternLinked(const uint32_t trackId) const
+{
+    const auto* slot = tracks.find(trackId);
+    if (slot == nullptr)
+        return false;
+
+    const Track* track = slot->get();
+    return std::ranges::any_of(tracks, [track](const auto& other) {
+        return other.get() != track && other->getSharedPattern() == track->getSharedPattern();
+    });
+}
+
+bool Sequencer::handOverPatternTree(Track& track)
+{
+    if (!track.holdsPatternTree())
+        return false;
+
+    for (const auto& other : tracks)
     {
-        if (track->getId() == trackId)
+        if (other.get() != &track && other->getSharedPattern() == track.getSharedPattern())
         {
-            return *track;
+            other->takePatternTree();
+            return true;
         }
     }
 
+    return false;
+}
+
+void Sequencer::patternsChanged(const uint32_t trackId)
+{
+    // The engine picks up the track's new pattern with the next list, and the old one is
+    // freed once it has let go
+    publishTrackList();
+
+    if (recordArmedTrackId == trackId)
+        setRecordArmedTrack(trackId);
+}
+
+Track& Sequencer::getTrack(const uint32_t trackId)
+{
+    if (auto* track = findTrack(trackId))
+        return *track;
+
     DBG("Internal State: " << state.toXmlString());
     throw std::runtime_error("Track not found for id: " + std::to_string(trackId));
 }
 
-std::vector<std::unique_ptr<Track>>& Sequencer::getTracks()
+Track* Sequencer::findTrack(const uint32_t trackId)
+{
+    auto* track = tracks.find(trackId);
+    return track != nullptr ? track->get() : nullptr;
+}
+
+Sequencer::TrackSlots& Sequencer::getTracks()
 {
     return tracks;
 }
@@ -114,36 +200,380 @@ Pattern& Sequencer::getCurrentPatternForTrack(uint32_t trackId)
     return getTrack(trackId).getCurrentPattern();
 }
 
-void Sequencer::prepare(const double sampleRate)
+void Sequencer::prepare(const double sampleRate, const int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
     timingManager.prepare(sampleRate);
+
+    // Everything the engine fills per block is sized here, so processing never allocates.
+    // Dense patterns can put a note on and off on every sample of a long block
+    const size_t generatedEvents =
+        std::max(MIN_OUTPUT_EVENTS, 2 * static_cast<size_t>(std::max(samplesPerBlock, 0)));
+    outputEvents.prepare(generatedEvents + MAX_THRU_EVENTS, 3 * generatedEvents + MIDI_BUFFER_BYTES);
+    outputMidi.ensureSize(static_cast<size_t>(outputEvents.getMidiBufferBytes()));
+    spareOutputMidi.ensureSize(static_cast<size_t>(outputEvents.getMidiBufferBytes()));
+    playedMidi.ensureSize(static_cast<size_t>(MIDI_BUFFER_BYTES));
+    stepProcessor.prepare(MAX_TRACKS);
+    activeSteps.reserve(ACTIVE_STEPS_CAPACITY);
+    chaseCandidates.reserve(ACTIVE_STEPS_CAPACITY);
 }
 
-void Sequencer::processBlock(const juce::AudioPlayHead* playHead, const int numSamples, juce::MidiBuffer& midiOut)
+int Sequencer::getOutputBufferBytes() const
 {
-    timingManager.processBlock(playHead, numSamples);
+    return outputEvents.getMidiBufferBytes();
+}
+
+void Sequencer::processBlock(
+    const juce::AudioPlayHead* playHead,
+    const int numSamples,
+    juce::MidiBuffer& midiMessages)
+{
+    const juce::MidiBuffer& midiIn = midiMessages;
+
+    // Everything the engine generates is collected here and written out in one sorted pass
+    outputEvents.clear();
+
+    // Pick up tracks added, removed, muted or soloed since the last block
+    syncTrackList(outputEvents);
+
+    // Keep up with the control keyboard even while stopped so the first bar plays in the right key.
+    // Its channel goes no further, it isn't played, recorded or passed through
+    keyboardControl.processBlock(midiIn);
+    const juce::MidiBuffer& played = keyboardControl.removeControlMessages(midiIn, playedMidi);
+
+    timingManager.processBlock(playHead, numSamples, midiIn);
+
+    // Clock goes first so it leads any notes that share its sample
+    if (timingManager.getCurrentTiming().has(TimingInfo::HAS_PPQ_POSITION | TimingInfo::HAS_BPM))
+        midiClockGenerator.process(timingManager.isTransportPlaying(), timingManager.getEngineTiming(), outputEvents);
 
-    const auto ppqPos = timingManager.getPpqPosition();
-    const auto bpm = timingManager.getBpm();
+    processTracks(played, outputEvents);
 
-    if (!ppqPos.has_value() || !bpm.has_value())
+    // Thru runs whether or not the transport is playing
+    if (midiThru.isEnabled())
+    {
+        const int targetChannel = midiThru.isRechannelizing() ? getSelectedTrackChannel() : 0;
+        midiThru.process(played, outputEvents, targetChannel);
+    }
+
+    // Nothing reads the input past here
+    outputEvents.writeTo(outputMidi);
+    handOverOutput(midiMessages);
+}
+
+void Sequencer::handOverOutput(juce::MidiBuffer& midiMessages)
+{
+    // The host's buffer takes the reserved storage the output was written in, so it never
+    // grows on the audio thread, and the scratch takes the host's storage in return. Hosts
+    // hand the same buffer back every block, with the storage it was given last time, so
+    // from then on two reserved buffers just trade places. Storage from anywhere else may
+    // be too small to write in. It is parked in the spare, which is swapped in instead, and
+    // reserved again by the next prepare()
+    midiMessages.swapWith(outputMidi);
+
+    const juce::uint8* received = outputMidi.data.begin();
+    if (received == nullptr || received != handedOutStorage)
+        outputMidi.swapWith(spareOutputMidi);
+
+    handedOutStorage = midiMessages.data.begin();
+    outputMidi.clear();
+}
+
+void Sequencer::processTracks(const juce::MidiBuffer& midiIn, MidiEventQueue& midiOut)
+{
+    if (!timingManager.getCurrentTiming().has(TimingInfo::HAS_PPQ_POSITION | TimingInfo::HAS_BPM))
     {
         return;
     }
 
-    // Calculate tick range for this block
-    const double samplesPerTick = (60.0 / *bpm / PPQN) * currentSampleRate;
-    const double samplesToTicks = 1.0 / samplesPerTick;
+    if (!timingManager.isTransportPlaying())
+    {
+        // Nothing new starts while stopped, but notes already playing must not hang.
+        // Mute changes have no boundary to wait for
+        stepProcessor.flushNoteOffs(midiOut);
+        stopArpeggiators(midiOut);
+        appliedSilence = getRequestedSilence();
+        pendingSilence = 0;
+        return;
+    }
 
-    const int startTick = static_cast<int>(*ppqPos * PPQN);
-    const int numTicks = static_cast<int>(numSamples * samplesToTicks);
+    // Exact tick window for this block, consecutive blocks tile the timeline. It trails the
+    // host by the lookahead, so output lines up once the host compensates for the latency
+    const auto& timing = timingManager.getEngineTiming();
+    const auto startTick = static_cast<int>(timing.startTick);
+    const auto numTicks = static_cast<int>(timing.getNumTicks());
 
-    // Process each track's steps
-    for (const auto& track : getTracks())
+    // After a loop or relocation nothing scheduled for the old position applies any more.
+    // Arpeggiators restart their pattern from the new position too
+    if (timingManager.hasJumped())
     {
-        auto activeSteps = track->getActiveSteps(startTick, numTicks);
-        stepProcessor.processSteps(activeSteps, track->getTrackInfo(), globalScale, startTick, numTicks, midiOut);
+        stepProcessor.flushNoteOffs(midiOut);
+        stopArpeggiators(midiOut);
+    }
+
+    // Playback starts afresh at the block, after a jump or from a standstill
+    const bool restarted = timingManager.hasJumped() || timingManager.hasStartedPlaying();
+    const bool chase = chaseNotes.load(std::memory_order_relaxed) && restarted;
+
+    // Releases go out first so a note retriggered on the same sample isn't cut off
+    stepProcessor.processNoteOffs(timing, midiOut);
+
+    // Incoming notes are stamped with where the host is, which is what the player heard
+    midiRecorder.captureBlock(midiIn, timingManager.getBlockTiming());
+
+    // Held notes on the control channel take over from the global scale when following
+    const ScaleTable* followedScale = keyboardControl.getFollowedScale();
+    const ScaleTable& scale = followedScale != nullptr ? *followedScale : scaleTables.read();
+    const int keyboardTranspose = keyboardControl.getTranspose();
+
+    // Automated swing applies from this block on. Triggers compiled with another amount are
+    // moved by the difference until the model catches up and recompiles them
+    const int swingTicks = parameters != nullptr ? static_cast<int>(PPQN * parameters->getSwing()) : 0;
+
+    // Schedule mute and solo changes, each track switches on its own quantization boundary
+    const uint64_t switching = scheduleSilenceChanges(timing);
+
+    // Process each track's steps, walking the trigger table once in slot order
+    const auto& engineTrackList = engineTracks->tracks;
+    const auto& triggers = engineTracks->triggers;
+    for (size_t slot = 0; slot < engineTrackList.size(); ++slot)
+    {
+        Track* track = engineTrackList[slot];
+        auto& arpeggiator = track->getArpeggiator();
+
+        const uint64_t bit = uint64_t{1} << slot;
+        const bool silenced = (appliedSilence & bit) != 0;
+        const bool switches = (switching & bit) != 0;
+        const int64_t switchTick = switches ? silenceSwitchTicks[slot] : 0;
+
+        // A silenced track starts nothing new. Its note-offs were sent when it was silenced
+        if (silenced && !switches)
+        {
+            if (!arpeggiator.isIdle())
+                arpeggiator.stop(midiOut);
+            continue;
+        }
+
+        const auto settings = track->getEngineSettings();
+        auto trackInfo = settings.trackInfo;
+        if (settings.keyboardTranspose)
+            trackInfo.transpose = static_cast<int8_t>(keyboardTranspose);
+
+        if (parameters != nullptr)
+        {
+            const int transpose = trackInfo.transpose + parameters->getTrackTranspose(trackInfo.id);
+            trackInfo.transpose = static_cast<int8_t>(transpose);
+            trackInfo.probabilityScale = parameters->getTrackProbability(trackInfo.id);
+        }
+
+        const auto& arpSettings = settings.arp;
+        const int swingDelta =
+            parameters != nullptr ? swingTicks - triggers.getTrack(slot).swingTicks : 0;
+
+        // Humanized and re-swung triggers can move into this block from either neighbour, so look
+        // that much further each way. The step processor only plays the ones that land inside it
+        const auto& humanize = settings.humanize;
+        const int reach = (humanize.isActive() ? humanize.timingTicks : 0) + std::abs(swingDelta);
+        if (!triggers.collect(slot, startTick - reach, numTicks + 2 * reach, activeSteps))
+        {
+            jassertfalse; // More triggers than the scratch was sized for, the rest are left out
+        }
+        if (humanize.isActive())
+            Humanize::apply(activeSteps.data(), activeSteps.size(), humanize, trackInfo.id);
+
+        if (swingDelta != 0)
+        {
+            for (auto& active : activeSteps)
+            {
+                if (active.swung)
+                    active.tick += swingDelta;
+            }
+        }
+
+        // After a jump the block owns the triggers written from its start on, wherever they
+        // were moved to. Those pulled in front of it play on its first tick rather than not
+        // at all, and those written before it belong to the old position or the chase
+        if (restarted && reach > 0)
+        {
+            std::erase_if(activeSteps, [startTick](const ActiveStep& active) {
+                return active.triggerTick < startTick;
+            });
+            for (auto& active : activeSteps)
+                active.tick = std::max(active.tick, startTick);
+        }
+
+        // Only the part of the block the track is audible in plays
+        if (switches)
+        {
+            std::erase_if(activeSteps, [silenced, switchTick](const ActiveStep& active) {
+                return (active.tick < switchTick) == silenced;
+            });
+        }
+
+        const bool chaseTrackNotes = chase && !silenced;
+
+        if (arpSettings.mode == ArpMode::Off)
+        {
+            if (!arpeggiator.isIdle())
+                arpeggiator.stop(midiOut);
+
+            if (chaseTrackNotes)
+                chaseTrack(slot, trackInfo, scale, timing, midiOut, nullptr);
+
+            stepProcessor.processSteps(activeSteps, trackInfo, scale, timing, midiOut);
+        }
+        else
+        {
+            // The arpeggiator sits after the step processor and plays whatever the
+            // track's steps (or the incoming notes on its channel) are holding
+            if (arpSettings.source == ArpSource::Steps)
+            {
+                if (chaseTrackNotes)
+                    chaseTrack(slot, trackInfo, scale, timing, midiOut, &arpeggiator);
+
+                stepProcessor.processSteps(activeSteps, trackInfo, scale, timing, midiOut, &arpeggiator);
+            }
+            else
+            {
+                feedArpeggiatorInput(*track, midiIn, timing);
+            }
+
+            arpeggiator.process(arpSettings, trackInfo.midiChannel, timing, midiOut);
+        }
+
+        if (switches)
+        {
+            // Cut everything still sounding on the switch, however long ago it started. The
+            // arpeggiator has already played the whole block, so it is cut at the block's end
+            if (!silenced)
+            {
+                stepProcessor.flushTrackNoteOffs(trackInfo.id, midiOut, timing.tickToSampleOffset(switchTick));
+                arpeggiator.stop(midiOut, std::max(0, timing.numSamples - 1));
+            }
+
+            appliedSilence ^= bit;
+            pendingSilence &= ~bit;
+        }
+    }
+}
+
+uint64_t Sequencer::getRequestedSilence() const
+{
+    // Requests from the model and the host's mute parameters, one bit per track slot
+    uint64_t requested = engineTracks->silenced;
+    if (parameters != nullptr)
+    {
+        for (size_t slot = 0; slot < engineTracks->tracks.size(); ++slot)
+        {
+            if (parameters->isTrackMuted(engineTracks->tracks[slot]->getEngineSettings().trackInfo.id))
+                requested |= uint64_t{1} << slot;
+        }
+    }
+    return requested;
+}
+
+uint64_t Sequencer::scheduleSilenceChanges(const BlockTiming& timing)
+{
+    // A request withdrawn before its boundary came round is dropped
+    const uint64_t changed = getRequestedSilence() ^ appliedSilence;
+    pendingSilence &= changed;
+
+    uint64_t switching = 0;
+    for (size_t slot = 0; slot < engineTracks->tracks.size(); ++slot)
+    {
+        const uint64_t bit = uint64_t{1} << slot;
+        if ((changed & bit) == 0)
+            continue;
+
+        if ((pendingSilence & bit) == 0)
+        {
+            silenceSwitchTicks[slot] =
+                getSilenceSwitchTick(engineTracks->triggers.getTrack(slot).stepTicks, timing.startTick);
+            pendingSilence |= bit;
+        }
+
+        if (silenceSwitchTicks[slot] < timing.endTick)
+            switching |= bit;
+    }
+
+    return switching;
+}
+
+int64_t Sequencer::getSilenceSwitchTick(const int stepTicks, const int64_t fromTick) const
+{
+    const auto& current = timingManager.getCurrentTiming();
+    const bool hasMeter = current.has(TimingInfo::HAS_TIME_SIGNATURE) && current.timeSigDenominator > 0;
+    const int64_t beatTicks = hasMeter ? 4 * PPQN / current.timeSigDenominator : PPQN;
+    const int64_t barTicks = beatTicks * (hasMeter ? current.timeSigNumerator : 4);
+
+    int64_t grid = 1;
+    switch (muteQuantize.load(std::memory_order_relaxed))
+    {
+        case MuteQuantize::NextStep:
+            grid = stepTicks;
+            break;
+        case MuteQuantize::NextBeat:
+            grid = beatTicks;
+            break;
+        case MuteQuantize::NextBar:
+            grid = barTicks; // Bars counted from zero in the current meter
+            break;
+        case MuteQuantize::Immediate:
+        default:
+            return fromTick;
+    }
+
+    grid = std::max<int64_t>(grid, 1);
+    return mulDivCeil(fromTick, 1, grid) * grid;
+}
+
+void Sequencer::feedArpeggiatorInput(Track& track, const juce::MidiBuffer& midiIn, const BlockTiming& timing)
+{
+    const int channel = track.getEngineSettings().trackInfo.midiChannel;
+    auto& arpeggiator = track.getArpeggiator();
+
+    for (const auto metadata : midiIn)
+    {
+        const auto message = metadata.getMessage();
+        if (message.getChannel() != channel)
+            continue;
+
+        const auto tick = static_cast<int>(timing.tickAtSample(metadata.samplePosition));
+        if (message.isNoteOn())
+            arpeggiator.addNote(tick, static_cast<uint8_t>(message.getNoteNumber()), message.getVelocity());
+        else if (message.isNoteOff())
+            arpeggiator.addNote(tick, static_cast<uint8_t>(message.getNoteNumber()), 0);
+    }
+}
+
+void Sequencer::chaseTrack(
+    const size_t slot,
+    const TrackInfo& trackInfo,
+    const ScaleTable& scale,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut,
+    Arpeggiator* arpeggiator)
+{
+    // Only notes long enough to reach the block can still be sounding, so look up the
+    // triggers in that window rather than replaying the pattern. Nothing plays before zero
+    const auto startTick = static_cast<int>(timing.startTick);
+    const int windowStart = std::max(startTick - StepProcessor::CHASE_WINDOW_TICKS, 0);
+    if (windowStart >= startTick)
+        return;
+
+    if (!engineTracks->triggers.collect(slot, windowStart, startTick - windowStart, chaseCandidates))
+    {
+        jassertfalse; // Can't happen, the scratch is sized for the chase window
+    }
+    stepProcessor.chaseSteps(chaseCandidates, trackInfo, scale, timing, midiOut, arpeggiator);
+}
+
+void Sequencer::stopArpeggiators(MidiEventQueue& midiOut)
+{
+    for (Track* track : engineTracks->tracks)
+    {
+        if (auto& arpeggiator = track->getArpeggiator(); !arpeggiator.isIdle())
+            arpeggiator.stop(midiOut);
     }
 }
 
@@ -178,6 +608,7 @@ void Sequencer::setScale(Scale::Type type, uint8_t root)
     scaleType = type;
     scaleRoot = root % 12;
     globalScale = Scale(type, root);
+    publishScale();
 }
 
 void Sequencer::setCustomScale(const std::vector<uint8_t>& degrees, uint8_t root)
@@ -186,22 +617,267 @@ void Sequencer::setCustomScale(const std::vector<uint8_t>& degrees, uint8_t root
     scaleRoot = root % 12;
     globalCustomDegrees = degrees;
     globalScale = Scale(degrees, root);
+    publishScale();
+}
+
+void Sequencer::publishScale()
+{
+    // The audio thread picks this up at the start of its next block
+    scaleTables.write(ScaleTable::fromScale(globalScale));
+}
+
+void Sequencer::setKeyboardChannel(const int channel)
+{
+    setProperty(props.keyboardChannel, juce::jlimit(0, 16, channel));
+    applyProperty(props.keyboardChannel.index);
+}
+
+int Sequencer::getKeyboardChannel() const
+{
+    return getProperty(props.keyboardChannel);
+}
+
+void Sequencer::setKeyboardReferenceNote(const int note)
+{
+    setProperty(props.keyboardReferenceNote, juce::jlimit(0, 127, note));
+    applyProperty(props.keyboardReferenceNote.index);
+}
+
+int Sequencer::getKeyboardReferenceNote() const
+{
+    return getProperty(props.keyboardReferenceNote);
+}
+
+void Sequencer::setScaleFollow(const bool shouldFollow)
+{
+    setProperty(props.scaleFollow, shouldFollow);
+    applyProperty(props.scaleFollow.index);
+}
+
+bool Sequencer::getScaleFollow() const
+{
+    return getProperty(props.scaleFollow);
+}
+
+KeyboardControl& Sequencer::getKeyboardControl()
+{
+    return keyboardControl;
+}
+
+void Sequencer::setChaseNotes(const bool shouldChase)
+{
+    setProperty(props.chaseNotes, shouldChase);
+    applyProperty(props.chaseNotes.index);
+}
+
+bool Sequencer::getChaseNotes() const
+{
+    return getProperty(props.chaseNotes);
+}
+
+void Sequencer::setTrackMuted(const uint32_t trackId, const bool shouldBeMuted)
+{
+    getTrack(trackId).setMuted(shouldBeMuted);
+    publishTrackList();
+}
+
+void Sequencer::setTrackSoloed(const uint32_t trackId, const bool shouldBeSoloed)
+{
+    getTrack(trackId).setSoloed(shouldBeSoloed);
+    publishTrackList();
+}
+
+void Sequencer::setMuteQuantize(const MuteQuantize quantize)
+{
+    setProperty(props.muteQuantize, quantize);
+    applyProperty(props.muteQuantize.index);
+}
+
+MuteQuantize Sequencer::getMuteQuantize() const
+{
+    return getProperty(props.muteQuantize);
+}
+
+void Sequencer::publishTrackList(std::vector<std::unique_ptr<Track>> retiredTracks)
+{
+    std::vector<Track*> engineOrder;
+    engineOrder.reserve(tracks.size());
+    size_t numTriggers = 0;
+    for (const auto& track : tracks)
+    {
+        engineOrder.push_back(track.get());
+        numTriggers += track->getCurrentPattern().getTriggers()->size();
+    }
+
+    // Every slot's compiled pattern in one table. A linked track plays the range of the
+    // first track in its link, the pattern is stored once
+    TriggerTable triggers;
+    triggers.reserve(tracks.size(), numTriggers);
+    for (size_t slot = 0; slot < tracks.size(); ++slot)
+    {
+        const auto& pattern = tracks[slot]->getSharedPattern();
+        size_t first = 0;
+        while (tracks[first]->getSharedPattern() != pattern)
+            ++first;
+
+        if (first < slot)
+            triggers.addLinkedTrack(first);
+        else
+            triggers.addTrack(*pattern->getTriggers());
+    }
+
+    // Any solo silences every track that isn't soloed, otherwise the mutes decide
+    const bool anySoloed = std::ranges::any_of(tracks, [](const auto& track) { return track->isSoloed(); });
+
+    uint64_t silenced = 0;
+    for (size_t slot = 0; slot < tracks.size() && slot < MAX_TRACKS; ++slot)
+    {
+        const auto& track = *tracks[slot];
+        if (anySoloed ? !track.isSoloed() : track.isMuted())
+            silenced |= uint64_t{1} << slot;
+    }
+
+    trackLists.publish(std::move(engineOrder), std::move(triggers), silenced, std::move(retiredTracks));
+}
+
+void Sequencer::syncTrackList(MidiEventQueue& midiOut)
+{
+    const TrackList* latest = trackLists.getLatest();
+    if (latest == engineTracks)
+        return;
+
+    // Mute state follows each track to its new slot. A new track starts as it was requested,
+    // there is nothing playing to wait for
+    uint64_t applied = latest->silenced;
+    uint64_t pending = 0;
+    std::array<int64_t, MAX_TRACKS> switchTicks{};
+
+    const std::vector<Track*> noTracks;
+    const auto& previous = engineTracks != nullptr ? engineTracks->tracks : noTracks;
+    for (size_t oldSlot = 0; oldSlot < previous.size(); ++oldSlot)
+    {
+        Track* track = previous[oldSlot];
+        const auto it = std::ranges::find(latest->tracks, track);
+
+        // Still alive until acknowledged below, so its notes can be ended here
+        if (it == latest->tracks.end())
+        {
+            stepProcessor.flushTrackNoteOffs(track->getEngineSettings().trackInfo.id, midiOut, 0);
+            if (auto& arpeggiator = track->getArpeggiator(); !arpeggiator.isIdle())
+                arpeggiator.stop(midiOut);
+            continue;
+        }
+
+        const auto newSlot = static_cast<size_t>(std::distance(latest->tracks.begin(), it));
+        const uint64_t oldBit = uint64_t{1} << oldSlot;
+        const uint64_t newBit = uint64_t{1} << newSlot;
+        applied = (applied & ~newBit) | ((appliedSilence & oldBit) != 0 ? newBit : 0);
+        pending |= (pendingSilence & oldBit) != 0 ? newBit : 0;
+        switchTicks[newSlot] = silenceSwitchTicks[oldSlot];
+    }
+
+    appliedSilence = applied;
+    pendingSilence = pending;
+    silenceSwitchTicks = switchTicks;
+
+    engineTracks = latest;
+    trackLists.acknowledge(latest->epoch);
+}
+
+void Sequencer::setLookaheadMs(const double ms)
+{
+    setProperty(props.lookaheadMs, juce::jlimit(0.0, TimingManager::MAX_LOOKAHEAD_MS, ms));
+    applyProperty(props.lookaheadMs.index);
+}
+
+double Sequencer::getLookaheadMs() const
+{
+    return getProperty(props.lookaheadMs);
 }
 
-uint32_t Sequencer::generateTrackId()
+int Sequencer::getLatencySamples() const
 {
-    return nextTrackId++;
+    return timingManager.getLatencySamples();
+}
+
+void Sequencer::applyProperty(const size_t index)
+{
+    // The engine's copies of the settings follow the tree, so undo and redo reach it too
+    switch (index)
+    {
+        case props.keyboardChannel.index:
+            keyboardControl.setControlChannel(getProperty(props.keyboardChannel));
+            break;
+        case props.keyboardReferenceNote.index:
+            keyboardControl.setReferenceNote(getProperty(props.keyboardReferenceNote));
+            break;
+        case props.scaleFollow.index:
+            keyboardControl.setScaleFollow(getProperty(props.scaleFollow));
+            break;
+        case props.chaseNotes.index:
+            chaseNotes.store(getProperty(props.chaseNotes), std::memory_order_relaxed);
+            break;
+        case props.lookaheadMs.index:
+        {
+            const int latency = timingManager.getLatencySamples();
+            timingManager.setLookaheadMs(getProperty(props.lookaheadMs));
+            if (timingManager.getLatencySamples() != latency && onLatencyChanged != nullptr)
+                onLatencyChanged(timingManager.getLatencySamples());
+            break;
+        }
+        case props.muteQuantize.index:
+            muteQuantize.store(getProperty(props.muteQuantize), std::memory_order_relaxed);
+            break;
+        default:
+            break;
+    }
 }
 
 size_t Sequencer::getTrackCount() const
 {
-    size_t count = 0;
-    for (int i = 0; i < state.getNumChildren(); ++i)
+    return tracks.size();
+}
+
+ChangeDispatcher& Sequencer::getChangeDispatcher()
+{
+    return changeDispatcher;
+}
+
+void Sequencer::modelChanged(const std::vector<ChangeEvent>& changes)
+{
+    // Patterns recompile their triggers once for the whole batch, and tracks pass their
+    // settings on to the engine, whether they were edited, undone or redone
+    bool silenceChanged = false;
+    for (const auto& change : changes)
     {
-        if (state.getChild(i).hasType(ID::track))
-            count++;
+        if (change.node == ChangeEvent::Node::Sequencer)
+        {
+            applyProperty(change.property);
+            continue;
+        }
+
+        auto* track = findTrack(change.trackId);
+        if (track == nullptr)
+            continue;
+
+        if (change.node == ChangeEvent::Node::Track && change.property != ChangeEvent::CHILDREN)
+        {
+            track->publishSettings();
+            silenceChanged = silenceChanged || change.property == Track::Schema::mute.index ||
+                change.property == Track::Schema::solo.index;
+        }
+        else if (change.node == ChangeEvent::Node::Pattern || change.node == ChangeEvent::Node::Step)
+            track->getCurrentPattern().handleChange(change);
     }
-    return count;
+
+    // Linked tracks share a pattern, which only has anything to commit the first time
+    bool recompiled = false;
+    for (const auto& track : tracks)
+        recompiled = track->getCurrentPattern().commitChanges() || recompiled;
+
+    // New triggers, mutes and solos reach the engine in a new track list
+    if (recompiled || silenceChanged)
+        publishTrackList();
 }
 
 TimingManager& Sequencer::getTimingManager()
@@ -209,6 +885,68 @@ TimingManager& Sequencer::getTimingManager()
     return timingManager;
 }
 
+void Sequencer::setRecordArmedTrack(const std::optional<uint32_t> trackId)
+{
+    recordArmedTrackId = trackId;
+    midiRecorder.setTargetPattern(trackId.has_value() ? getTrack(*trackId).getSharedPattern() : nullptr);
+}
+
+std::optional<uint32_t> Sequencer::getRecordArmedTrack() const
+{
+    return recordArmedTrackId;
+}
+
+void Sequencer::setRecording(const bool shouldRecord)
+{
+    midiRecorder.setRecording(shouldRecord);
+}
+
+bool Sequencer::isRecording() const
+{
+    return midiRecorder.isRecording();
+}
+
+MidiRecorder& Sequencer::getMidiRecorder()
+{
+    return midiRecorder;
+}
+
+MidiThru& Sequencer::getMidiThru()
+{
+    return midiThru;
+}
+
+MidiClockGenerator& Sequencer::getMidiClockGenerator()
+{
+    return midiClockGenerator;
+}
+
+void Sequencer::setParameters(const Parameters* parametersToUse)
+{
+    parameters = parametersToUse;
+}
+
+void Sequencer::setSelectedTrack(const uint32_t trackId)
+{
+    selectedTrackId.store(trackId, std::memory_order_relaxed);
+}
+
+uint32_t Sequencer::getSelectedTrack() const
+{
+    return selectedTrackId.load(std::memory_order_relaxed);
+}
+
+uint8_t Sequencer::getSelectedTrackChannel() const
+{
+    const uint32_t trackId = getSelectedTrack();
+    for (const Track* track : engineTracks->tracks)
+    {
+        if (const auto trackInfo = track->getEngineSettings().trackInfo; trackInfo.id == trackId)
+            return trackInfo.midiChannel;
+    }
+    return 0;
+}
+
 void Sequencer::updateTrackSwing()
 {
     const float amount = getProperty(props.swingAmount);
@@ -3,42 +3,133 @@
 #include "../Constants.h"
 #include "../Identifiers.h"
 #include "../JuceHeader.h"
+#include "ChangeDispatcher.h"
+#include "KeyboardControl.h"
+#include "MidiClockGenerator.h"
+#include "MidiEventQueue.h"
+#include "MidiRecorder.h"
+#include "MidiThru.h"
+#include "ScaleTable.h"
+#include "SlotMap.h"
 #include "StepProcessor.h"
 #include "TimingManager.h"
 #include "Track.h"
+#include "TrackList.h"
+#include "TripleBuffer.h"
 #include "ValueTreeObject.h"
 
 #include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace Sirkus::Core {
 
-class Sequencer final : public ValueTreeObject
+class Parameters;
+
+class Sequencer final
+    : public ValueTreeObject
+      , private ChangeDispatcher::Subscriber
 {
 public:
-    Sequencer(ValueTree parentState, UndoManager& undoManagerToUse);
+    Sequencer(ValueTree parentState, UndoHistory& undoHistoryToUse);
 
-    struct Properties
+    struct Schema
     {
-        TypedProperty<float> swingAmount{ID::Sequencer::swingAmount, 0.0f};
+        static constexpr TypedProperty<float> swingAmount{ID::Sequencer::swingAmount, 0.0f, 0};
+        static constexpr TypedProperty<int> keyboardChannel{ID::Sequencer::keyboardChannel, 0, 1};
+        static constexpr TypedProperty<int> keyboardReferenceNote{
+            ID::Sequencer::keyboardReferenceNote,
+            KeyboardControl::DEFAULT_REFERENCE_NOTE,
+            2};
+        static constexpr TypedProperty<bool> scaleFollow{ID::Sequencer::scaleFollow, false, 3};
+        static constexpr TypedProperty<bool> chaseNotes{ID::Sequencer::chaseNotes, true, 4};
+        static constexpr TypedProperty<double> lookaheadMs{ID::Sequencer::lookaheadMs, 0.0, 5};
+        static constexpr TypedProperty<MuteQuantize> muteQuantize{
+            ID::Sequencer::muteQuantize,
+            MuteQuantize::Immediate,
+            6};
+        static constexpr size_t NUM_PROPERTIES = 7;
+
+        static int indexOf(const juce::Identifier& id)
+        {
+            return findPropertyIndex(
+                id,
+                swingAmount,
+                keyboardChannel,
+                keyboardReferenceNote,
+                scaleFollow,
+                chaseNotes,
+                lookaheadMs,
+                muteQuantize);
+        }
     };
 
-    // Track Management
-    uint32_t createTrack();             // Returns nullptr if at MAX_TRACKS
+    static constexpr Schema props{};
+
+    // Track Management. A track id is a slot map handle: it stays valid for the track's
+    // lifetime and never refers to a later track
+    using TrackSlots = SlotMap<std::unique_ptr<Track>>;
+    static constexpr uint32_t INVALID_TRACK_ID = TrackSlots::INVALID_HANDLE;
+
+    uint32_t createTrack();             // Returns INVALID_TRACK_ID if at MAX_TRACKS
     bool removeTrack(uint32_t trackId); // Can't remove last track
-    Track& getTrack(uint32_t trackId);
-    std::vector<std::unique_ptr<Track>>& getTracks();
+    Track& getTrack(uint32_t trackId);  // Throws if there is no such track
+    Track* findTrack(uint32_t trackId);
+    TrackSlots& getTracks();
     Pattern& getCurrentPatternForTrack(uint32_t trackId);
 
     size_t getTrackCount() const;
 
+    // Linked patterns. Linked tracks play one shared pattern, so editing it from any of them
+    // changes them all, and it is stored and compiled once. Unlinking gives the track its own
+    // copy of the shared pattern to edit from then on. Linking and unlinking aren't edits and
+    // can't be undone, nor can removing a track whose pattern other tracks still share
+    bool linkPattern(uint32_t trackId, uint32_t sourceTrackId);
+    bool unlinkPattern(uint32_t trackId); // Returns false if the track isn't linked
+    bool isPatternLinked(uint32_t trackId) const;
+
+    // Mute and solo. Changes reach the engine as one bitmask and take effect on the
+    // next boundary of the mute quantization. Silencing a track ends its notes there
+    void setTrackMuted(uint32_t trackId, bool shouldBeMuted);
+    void setTrackSoloed(uint32_t trackId, bool shouldBeSoloed);
+    void setMuteQuantize(MuteQuantize quantize);
+    MuteQuantize getMuteQuantize() const;
+
     // Timing Control
     TimingManager& getTimingManager();
 
+    // Recording
+    void setRecordArmedTrack(std::optional<uint32_t> trackId);
+    std::optional<uint32_t> getRecordArmedTrack() const;
+    void setRecording(bool shouldRecord);
+    bool isRecording() const;
+    MidiRecorder& getMidiRecorder();
+
+    // MIDI thru, rechannelized input follows the selected track
+    MidiThru& getMidiThru();
+    void setSelectedTrack(uint32_t trackId);
+    uint32_t getSelectedTrack() const;
+
+    // MIDI clock, start/stop/continue and song position output
+    MidiClockGenerator& getMidiClockGenerator();
+
+    // Model changes, batched once per message loop turn
+    ChangeDispatcher& getChangeDispatcher();
+
+    // Host automatable parameters, read once per block. Set before processing starts
+    void setParameters(const Parameters* parametersToUse);
+
     // Audio Processing
-    void prepare(double sampleRate);
-    void processBlock(const juce::AudioPlayHead* playHead, int numSamples, juce::MidiBuffer& midiOut);
+    void prepare(double sampleRate, int samplesPerBlock);
+
+    // The size the host's output buffer needs for a block of output events, once prepared
+    int getOutputBufferBytes() const;
+
+    // midiMessages holds the host's input, which is replaced with the block's output
+    void processBlock(const juce::AudioPlayHead* playHead, int numSamples, juce::MidiBuffer& midiMessages);
 
     // Global Parameters
     void setSwingAmount(float amount);
@@ -51,18 +142,103 @@ public:
     uint8_t getScaleRoot() const;
     const std::vector<uint8_t>& getGlobalCustomDegrees() const;
 
-private:
-    Properties props;
+    // Keyboard transpose and scale follow. Channel 0 turns keyboard control off
+    void setKeyboardChannel(int channel);
+    int getKeyboardChannel() const;
+    void setKeyboardReferenceNote(int note);
+    int getKeyboardReferenceNote() const;
+    void setScaleFollow(bool shouldFollow);
+    bool getScaleFollow() const;
+    KeyboardControl& getKeyboardControl();
+
+    // Whether long notes that should be sounding are restarted when playback starts or jumps
+    void setChaseNotes(bool shouldChase);
+    bool getChaseNotes() const;
+
+    // Render this far ahead of the host so early steps can play before their grid position.
+    // The plugin must report getLatencySamples() to the host whenever this changes, which
+    // onLatencyChanged announces on the message thread, for undo and redo as well
+    void setLookaheadMs(double ms);
+    double getLookaheadMs() const;
+    int getLatencySamples() const;
+    std::function<void(int latencySamples)> onLatencyChanged;
 
-    uint32_t generateTrackId();
+private:
+    void modelChanged(const std::vector<ChangeEvent>& changes) override;
+    void applyProperty(size_t index); // Pass a sequencer property on to the engine
     void updateTrackSwing();
-
+    void publishScale();
+    void processTracks(const juce::MidiBuffer& midiIn, MidiEventQueue& midiOut);
+    uint8_t getSelectedTrackChannel() const;
+    void feedArpeggiatorInput(Track& track, const juce::MidiBuffer& midiIn, const BlockTiming& timing);
+    void stopArpeggiators(MidiEventQueue& midiOut);
+    void publishTrackList(std::vector<std::unique_ptr<Track>> retiredTracks = {});
+    void syncTrackList(MidiEventQueue& midiOut);
+    void handOverOutput(juce::MidiBuffer& midiMessages);
+    uint64_t getRequestedSilence() const;
+    uint64_t scheduleSilenceChanges(const BlockTiming& timing);
+    int64_t getSilenceSwitchTick(int stepTicks, int64_t fromTick) const;
+    bool handOverPatternTree(Track& track); // False unless the track held a tree another track took
+    void patternsChanged(uint32_t trackId);
+    void chaseTrack(
+        size_t slot,
+        const TrackInfo& trackInfo,
+        const ScaleTable& scale,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut,
+        Arpeggiator* arpeggiator);
+
+    UndoHistory& undoHistory;
+    ChangeDispatcher changeDispatcher{state};
     TimingManager timingManager;
     StepProcessor stepProcessor;
-    uint32_t nextTrackId{0};
-    std::vector<std::unique_ptr<Track>> tracks;
+
+    // The block's generated MIDI and thru, sorted into the output at the end. Incoming MIDI
+    // is reserved for as many short messages as a host's default buffer holds
+    static constexpr size_t MIN_OUTPUT_EVENTS = 1024;
+    static constexpr size_t MAX_THRU_EVENTS = MIDI_BUFFER_BYTES / 3;
+    MidiEventQueue outputEvents;
+
+    // The block's output is written here, in storage reserved in prepare(), then handed to the
+    // host by swapping buffers. See handOverOutput() for where the storage goes
+    juce::MidiBuffer outputMidi;
+    juce::MidiBuffer spareOutputMidi;
+    const juce::uint8* handedOutStorage{nullptr};
+
+    // Per track scratch for the steps in a block, and in the chase window before it. A window
+    // holds each step at most once per pattern cycle it touches, so at most window / step
+    // interval + steps triggers. Sized for the chase window, the longest the engine looks
+    // at, with the shortest step interval. Collecting stops there rather than allocating
+    static constexpr size_t ACTIVE_STEPS_CAPACITY =
+        StepProcessor::CHASE_WINDOW_TICKS / STEP_128TH + MAX_STEPS;
+    std::vector<ActiveStep> activeSteps;
+    std::vector<ActiveStep> chaseCandidates;
+    MidiRecorder midiRecorder{undoHistory};
+    std::optional<uint32_t> recordArmedTrackId;
+    MidiThru midiThru;
+    std::atomic<uint32_t> selectedTrackId{0};
+    std::atomic<bool> chaseNotes{true};
+
+    static_assert(MAX_TRACKS <= 64, "Track silence is kept in a 64-bit mask");
+    std::atomic<MuteQuantize> muteQuantize{MuteQuantize::Immediate};
+
+    // Audio thread mute state: what is applied, what is waiting for its boundary and where
+    uint64_t appliedSilence{0};
+    uint64_t pendingSilence{0};
+    std::array<int64_t, MAX_TRACKS> silenceSwitchTicks{};
+
+    KeyboardControl keyboardControl;
+    juce::MidiBuffer playedMidi; // The input without the control channel, when there is one
+    MidiClockGenerator midiClockGenerator;
+    const Parameters* parameters{nullptr};
+    TrackSlots tracks; // Message thread, dense in creation order
+
+    // Message -> audio thread. The engine plays the list it took at the start of the block
+    TrackListPublisher trackLists;
+    const TrackList* engineTracks{nullptr};
 
     Scale globalScale{Scale::Type::Major}; // Current global scale
+    TripleBuffer<ScaleTable> scaleTables{ScaleTable::fromScale(globalScale)}; // Message -> audio thread
     Scale::Type scaleType{Scale::Type::Major};
     uint8_t scaleRoot{0};
     std::vector<uint8_t> globalCustomDegrees;
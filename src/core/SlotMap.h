@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sirkus::Core {
+
+/*
+Values kept densely in insertion order, each reachable in O(1) through a stable handle.
+
+A handle is a slot index in the low 16 bits and the slot's generation in the high 16.
+Erasing a value bumps its slot's generation, so an old handle to a reused slot misses
+rather than finding the newcomer. Handles never change while their value lives, however
+the dense order moves. While nothing has been erased, handles are 0, 1, 2... in insertion
+order.
+
+The dense values iterate like a vector for code that walks them every block. Erasing
+keeps the order of the rest, which costs O(n) and is rare. Not thread safe.
+*/
+template <typename T>
+class SlotMap
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0xffffffffu;
+    static constexpr size_t MAX_SLOTS = 0xffff; // The top index is kept free for INVALID_HANDLE
+
+    // The handle the next insert() will return
+    [[nodiscard]] Handle getNextHandle() const
+    {
+        if (!freeSlots.empty())
+            return makeHandle(freeSlots.back(), slots[freeSlots.back()].generation);
+        return slots.size() < MAX_SLOTS ? makeHandle(static_cast<uint32_t>(slots.size()), 0) : INVALID_HANDLE;
+    }
+
+    Handle insert(T value)
+    {
+        const Handle handle = getNextHandle();
+        if (handle == INVALID_HANDLE)
+            return INVALID_HANDLE;
+
+        const uint32_t slot = handle & INDEX_MASK;
+        if (!freeSlots.empty())
+            freeSlots.pop_back();
+        else
+            slots.push_back({});
+
+        slots[slot].denseIndex = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        handles.push_back(handle);
+        return handle;
+    }
+
+    bool erase(const Handle handle)
+    {
+        const auto denseIndex = findDenseIndex(handle);
+        if (denseIndex == NOT_FOUND)
+            return false;
+
+        values.erase(values.begin() + static_cast<std::ptrdiff_t>(denseIndex));
+        handles.erase(handles.begin() + static_cast<std::ptrdiff_t>(denseIndex));
+        for (size_t i = denseIndex; i < handles.size(); ++i)
+            slots[handles[i] & INDEX_MASK].denseIndex = static_cast<uint32_t>(i);
+
+        auto& slot = slots[handle & INDEX_MASK];
+        slot.generation = static_cast<uint16_t>(slot.generation + 1);
+        slot.denseIndex = NOT_FOUND;
+        freeSlots.push_back(handle & INDEX_MASK);
+        return true;
+    }
+
+    [[nodiscard]] T* find(const Handle handle)
+    {
+        const auto denseIndex = findDenseIndex(handle);
+        return denseIndex != NOT_FOUND ? &values[denseIndex] : nullptr;
+    }
+
+    [[nodiscard]] const T* find(const Handle handle) const
+    {
+        const auto denseIndex = findDenseIndex(handle);
+        return denseIndex != NOT_FOUND ? &values[denseIndex] : nullptr;
+    }
+
+    [[nodiscard]] bool contains(const Handle handle) const { return findDenseIndex(handle) != NOT_FOUND; }
+
+    // A handle's slot index. It stays the same while the value lives, and is only reused once
+    // the value is erased. Always below the most values the map has held at once
+    [[nodiscard]] static constexpr size_t getSlotIndex(const Handle handle) { return handle & INDEX_MASK; }
+
+    // Dense access, in insertion order
+    [[nodiscard]] size_t size() const { return values.size(); }
+    [[nodiscard]] bool empty() const { return values.empty(); }
+    [[nodiscard]] Handle getHandle(const size_t denseIndex) const { return handles[denseIndex]; }
+    T& operator[](const size_t denseIndex) { return values[denseIndex]; }
+    const T& operator[](const size_t denseIndex) const { return values[denseIndex]; }
+    T& back() { return values.back(); }
+
+    auto begin() { return values.begin(); }
+    auto end() { return values.end(); }
+    auto begin() const { return values.begin(); }
+    auto end() const { return values.end(); }
+
+private:
+    static constexpr uint32_t INDEX_MASK = 0xffff;
+    static constexpr uint32_t NOT_FOUND = 0xffffffffu;
+
+    struct Slot
+    {
+        uint32_t denseIndex{NOT_FOUND};
+        uint16_t generation{0};
+    };
+
+    static Handle makeHandle(const uint32_t slot, const uint16_t generation)
+    {
+        return (static_cast<uint32_t>(generation) << 16) | slot;
+    }
+
+    [[nodiscard]] uint32_t findDenseIndex(const Handle handle) const
+    {
+        const uint32_t slot = handle & INDEX_MASK;
+        if (slot >= slots.size() || slots[slot].generation != (handle >> 16))
+            return NOT_FOUND;
+        return slots[slot].denseIndex;
+    }
+
+    std::vector<T> values;
+    std::vector<Handle> handles; // Parallel to values
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
+
+} // namespace Sirkus::Core
@@ -5,10 +5,8 @@ namespace Sirkus::Core {
 
 Step::Step(ValueTree parentState, UndoManager& undoManagerToUse, int index)
     : ValueTreeObject(parentState, ID::step, undoManagerToUse, index)
-      , props{}
 {
-    // Initialize default properties via props{} call
-
+    // Properties that were never set read back as their schema default
 }
 
 Step::Step(ValueTree existingState, UndoManager& undoManagerToUse, bool useExistingState)
@@ -18,5 +16,21 @@ Step::Step(ValueTree existingState, UndoManager& undoManagerToUse, bool useExist
     SIRKUS_UNUSED(useExistingState);
 }
 
+StepData Step::getData() const
+{
+    static_assert(Schema::NUM_PROPERTIES == 9, "StepData must list every property in Step::Schema");
+
+    return StepData{
+        isEnabled(),
+        getNote(),
+        getVelocity(),
+        getProbability(),
+        getTimingOffset(),
+        isAffectedBySwing(),
+        getTriggerTick(),
+        getTrackId(),
+        getNoteLength()};
+}
+
 
 } // namespace Sirkus::Core
@@ -10,6 +10,20 @@
 
 namespace Sirkus::Core {
 
+// A plain copy of a step's properties, field for field with Step::Schema
+struct StepData
+{
+    bool enabled{false};
+    uint8_t note{60};
+    uint8_t velocity{100};
+    float probability{1.0f};
+    float timingOffset{0.0f};
+    bool affectedBySwing{true};
+    int triggerTick{0};
+    uint32_t trackId{0};
+    TimeDivision noteLength{TimeDivision::SixteenthNote};
+};
+
 class Step final : public ValueTreeObject
 {
 public:
@@ -21,19 +35,37 @@ public:
 
     ~Step() override = default;
 
-    struct Properties
-    {
-        TypedProperty<bool> enabled{ID::Step::enabled, false};
-        TypedProperty<uint8_t> note{ID::Step::note, 60};
-        TypedProperty<uint8_t> velocity{ID::Step::velocity, 100};
-        TypedProperty<float> probability{ID::Step::probability, 1.0f};
-        TypedProperty<float> timingOffset{ID::Step::timingOffset, 0.0f};
-        TypedProperty<bool> affectedBySwing{ID::Step::affectedBySwing, true};
-        TypedProperty<int> triggerTick{ID::Step::triggerTick, 0};
-        TypedProperty<uint32_t> trackId{ID::Step::trackId, 0};
-        TypedProperty<TimeDivision> noteLength{ID::Step::noteLength, TimeDivision::SixteenthNote};
+    struct Schema
+    {
+        static constexpr TypedProperty<bool> enabled{ID::Step::enabled, false, 0};
+        static constexpr TypedProperty<uint8_t> note{ID::Step::note, 60, 1};
+        static constexpr TypedProperty<uint8_t> velocity{ID::Step::velocity, 100, 2};
+        static constexpr TypedProperty<float> probability{ID::Step::probability, 1.0f, 3};
+        static constexpr TypedProperty<float> timingOffset{ID::Step::timingOffset, 0.0f, 4};
+        static constexpr TypedProperty<bool> affectedBySwing{ID::Step::affectedBySwing, true, 5};
+        static constexpr TypedProperty<int> triggerTick{ID::Step::triggerTick, 0, 6};
+        static constexpr TypedProperty<uint32_t> trackId{ID::Step::trackId, 0, 7};
+        static constexpr TypedProperty<TimeDivision> noteLength{ID::Step::noteLength, TimeDivision::SixteenthNote, 8};
+        static constexpr size_t NUM_PROPERTIES = 9;
+
+        static int indexOf(const juce::Identifier& id)
+        {
+            return findPropertyIndex(
+                id,
+                enabled,
+                note,
+                velocity,
+                probability,
+                timingOffset,
+                affectedBySwing,
+                triggerTick,
+                trackId,
+                noteLength);
+        }
     };
 
+    static constexpr Schema props{};
+
     // Property getters/setters
     bool isEnabled() const
     {
@@ -131,8 +163,10 @@ public:
         return getNoteLength();
     }
 
+    // Every property in one read, for code that would otherwise look them up one at a time
+    StepData getData() const;
+
 private:
-    Properties props;
     JUCE_LEAK_DETECTOR(Step)
 };
 
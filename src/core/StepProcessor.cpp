@@ -1,4 +1,6 @@
 #include "StepProcessor.h"
+#include "Arpeggiator.h"
+#include "Humanize.h"
 #include "Track.h"
 #include "../Constants.h"
 #include <algorithm>
@@ -9,89 +11,258 @@ StepProcessor::StepProcessor() = default;
 
 StepProcessor::~StepProcessor() = default;
 
+void StepProcessor::prepare(const size_t maxTracks)
+{
+    // Only ever grows, so note-offs already pending survive a re-prepare
+    const size_t capacity = maxTracks * PENDING_NOTE_OFFS_PER_TRACK;
+    if (pendingNoteOffs.size() < capacity)
+        pendingNoteOffs.resize(capacity);
+}
+
 void StepProcessor::processSteps(
-    const std::vector<std::pair<int, const Step*>>& steps,
+    const std::vector<ActiveStep>& steps,
+    const TrackInfo& trackInfo,
+    const ScaleTable& scale,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut,
+    Arpeggiator* arpeggiator)
+{
+    const Kernel kernel = selectKernel(false, trackInfo, needsProbability(steps, trackInfo), arpeggiator != nullptr);
+    (this->*kernel)(steps, trackInfo, scale, timing, midiOut, arpeggiator);
+}
+
+void StepProcessor::chaseSteps(
+    const std::vector<ActiveStep>& steps,
+    const TrackInfo& trackInfo,
+    const ScaleTable& scale,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut,
+    Arpeggiator* arpeggiator)
+{
+    const Kernel kernel = selectKernel(true, trackInfo, needsProbability(steps, trackInfo), arpeggiator != nullptr);
+    (this->*kernel)(steps, trackInfo, scale, timing, midiOut, arpeggiator);
+}
+
+bool StepProcessor::needsProbability(const std::vector<ActiveStep>& steps, const TrackInfo& trackInfo)
+{
+    if (trackInfo.probabilityScale < 1.0f)
+        return true;
+
+    return std::any_of(steps.begin(), steps.end(), [](const ActiveStep& active) { return active.probability < 1.0f; });
+}
+
+uint64_t StepProcessor::triggerBits(const uint32_t trackId, const int triggerTick)
+{
+    // Salted so the bits don't repeat the humanize stage's for the same trigger
+    constexpr uint64_t salt = 0x70726F6261626C65ULL;
+    return Humanize::hash(
+        (Humanize::hash(trackId) ^ salt) ^ static_cast<uint64_t>(static_cast<uint32_t>(triggerTick)));
+}
+
+template <bool chase, ScaleMode scaleMode, bool useProbability, bool toArpeggiator>
+void StepProcessor::runKernel(
+    const std::vector<ActiveStep>& steps,
     const TrackInfo& trackInfo,
-    const Scale& scale,
-    int startTick,
-    int numTicks,
-    juce::MidiBuffer& midiOut)
+    const ScaleTable& scale,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut,
+    Arpeggiator* arpeggiator)
 {
-    // DBG("Processing steps for track: " << std::to_string(trackInfo.id));
-    // DBG("Given steps count: " << std::to_string(steps.size()));
-    // Process each active step
-    for (const auto& [triggerTick, step] : steps)
+    const auto chaseTick = static_cast<int>(timing.startTick);
+
+    for (const auto& active : steps)
     {
-        if (step &&
-            juce::Random::getSystemRandom().nextFloat() <= step->getProbability())
+        int onTick = active.tick;
+        const int offTick = active.tick + active.length;
+
+        if constexpr (chase)
         {
-            processStep(
-                *step,
-                trackInfo,
-                scale,
-                triggerTick,
-                startTick,
-                numTicks,
-                midiOut);
+            // Only notes started before the block and still held at its first tick
+            if (active.tick >= chaseTick || offTick <= chaseTick)
+                continue;
+            onTick = chaseTick;
+        }
+        else
+        {
+            if (!timing.contains(active.tick))
+                continue;
+        }
+
+        uint64_t bits = 0;
+        if constexpr (useProbability || scaleMode == ScaleMode::QuantizeRandom)
+            bits = triggerBits(trackInfo.id, active.triggerTick);
+
+        if constexpr (useProbability)
+        {
+            // The top 24 bits as a float in [0, 1)
+            const float roll = static_cast<float>(bits >> 40) * (1.0f / 16777216.0f);
+            if (roll >= active.probability * trackInfo.probabilityScale)
+                continue;
+        }
+
+        const uint8_t note = resolveNote<scaleMode>(active.note, trackInfo, scale, static_cast<uint32_t>(bits));
+        const auto velocity = static_cast<uint8_t>(std::clamp(active.velocity + active.velocityOffset, 1, 127));
+
+        if constexpr (toArpeggiator)
+        {
+            // Hand the note to the arpeggiator, which decides when things actually sound
+            arpeggiator->addNote(onTick, note, velocity, offTick);
+        }
+        else
+        {
+            playNote(trackInfo, note, velocity, onTick, offTick, timing, midiOut);
         }
     }
 }
 
-void StepProcessor::processStep(
-    const Step& step,
-    const TrackInfo& trackInfo,
-    const Scale& scale,
-    const int triggerTick,
-    const int startTick,
-    const int numTicks,
-    juce::MidiBuffer& midiOut)
+template <bool chase, ScaleMode scaleMode>
+StepProcessor::Kernel StepProcessor::selectKernel(const bool useProbability, const bool toArpeggiator)
 {
-    DBG("Processing step at tick: " << triggerTick << ", note: " << step.getNote());
+    if (useProbability)
+    {
+        return toArpeggiator ? &StepProcessor::runKernel<chase, scaleMode, true, true>
+                             : &StepProcessor::runKernel<chase, scaleMode, true, false>;
+    }
 
-    const int noteOnOffset = triggerTick - startTick;
+    return toArpeggiator ? &StepProcessor::runKernel<chase, scaleMode, false, true>
+                         : &StepProcessor::runKernel<chase, scaleMode, false, false>;
+}
 
-    // Apply scale quantization based on mode
-    uint8_t finalNote = step.getNote();
-    switch (trackInfo.scaleMode)
+template <bool chase>
+StepProcessor::Kernel StepProcessor::selectKernel(
+    const ScaleMode scaleMode,
+    const bool useProbability,
+    const bool toArpeggiator)
+{
+    switch (scaleMode)
     {
-        case ScaleMode::Off:
-            break;
         case ScaleMode::QuantizeUp:
-            finalNote = scale.quantizeUp(step.getNote());
-            break;
+            return selectKernel<chase, ScaleMode::QuantizeUp>(useProbability, toArpeggiator);
         case ScaleMode::QuantizeDown:
-            finalNote = scale.quantizeDown(step.getNote());
-            break;
+            return selectKernel<chase, ScaleMode::QuantizeDown>(useProbability, toArpeggiator);
         case ScaleMode::QuantizeRandom:
-            finalNote = scale.quantizeRandom(step.getNote());
-            break;
+            return selectKernel<chase, ScaleMode::QuantizeRandom>(useProbability, toArpeggiator);
+        case ScaleMode::Off:
         default:
-            break;
+            return selectKernel<chase, ScaleMode::Off>(useProbability, toArpeggiator);
     }
+}
 
-    const uint8_t channel = trackInfo.midiChannel;
-    const uint8_t velocity = step.getVelocity();
+StepProcessor::Kernel StepProcessor::selectKernel(
+    const bool chase,
+    const TrackInfo& trackInfo,
+    const bool useProbability,
+    const bool toArpeggiator)
+{
+    return chase ? selectKernel<true>(trackInfo.scaleMode, useProbability, toArpeggiator)
+                 : selectKernel<false>(trackInfo.scaleMode, useProbability, toArpeggiator);
+}
 
-    // Calculate note-off position based on note length
-    const auto noteLengthTicks = step.getNoteLengthInTicks();
-    const auto noteOffTick = triggerTick + noteLengthTicks;
-    const int noteOffOffset = noteOffTick - startTick;
+void StepProcessor::processNoteOffs(const BlockTiming& timing, MidiEventQueue& midiOut)
+{
+    for (size_t i = 0; i < numPendingNoteOffs;)
+    {
+        const auto& pending = pendingNoteOffs[i];
+        if (pending.tick < timing.endTick)
+        {
+            midiOut.addEvent(
+                juce::MidiMessage::noteOff(pending.channel, pending.note),
+                timing.tickToSampleOffset(pending.tick));
+            pendingNoteOffs[i] = pendingNoteOffs[numPendingNoteOffs - 1];
+            --numPendingNoteOffs;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
 
-    // Add note-on event if it falls within this block
-    if (noteOnOffset >= 0 && noteOnOffset < numTicks)
+void StepProcessor::flushNoteOffs(MidiEventQueue& midiOut, const int sampleOffset)
+{
+    for (size_t i = 0; i < numPendingNoteOffs; ++i)
     {
         midiOut.addEvent(
-            juce::MidiMessage::noteOn(channel, finalNote, velocity),
-            noteOnOffset);
+            juce::MidiMessage::noteOff(pendingNoteOffs[i].channel, pendingNoteOffs[i].note),
+            sampleOffset);
     }
 
-    // Add note-off event if it falls within this block
-    if (noteOffOffset >= 0 && noteOffOffset < numTicks)
+    numPendingNoteOffs = 0;
+}
+
+void StepProcessor::flushTrackNoteOffs(const uint32_t trackId, MidiEventQueue& midiOut, const int sampleOffset)
+{
+    for (size_t i = 0; i < numPendingNoteOffs;)
     {
-        midiOut.addEvent(
-            juce::MidiMessage::noteOff(channel, finalNote),
-            noteOffOffset);
+        const auto& pending = pendingNoteOffs[i];
+        if (pending.trackId == trackId)
+        {
+            midiOut.addEvent(juce::MidiMessage::noteOff(pending.channel, pending.note), sampleOffset);
+            pendingNoteOffs[i] = pendingNoteOffs[numPendingNoteOffs - 1];
+            --numPendingNoteOffs;
+        }
+        else
+        {
+            ++i;
+        }
     }
 }
 
+template <ScaleMode scaleMode>
+uint8_t StepProcessor::resolveNote(
+    const uint8_t note,
+    const TrackInfo& trackInfo,
+    const ScaleTable& scale,
+    const uint32_t randomBits)
+{
+    // Keyboard transpose first, so the transposed note still lands in the scale
+    const auto transposed = static_cast<uint8_t>(std::clamp(note + trackInfo.transpose, 0, 127));
+
+    if constexpr (scaleMode == ScaleMode::QuantizeUp)
+        return scale.quantizeUp(transposed);
+    else if constexpr (scaleMode == ScaleMode::QuantizeDown)
+        return scale.quantizeDown(transposed);
+    else if constexpr (scaleMode == ScaleMode::QuantizeRandom)
+        return scale.quantizeRandom(transposed, randomBits);
+    else
+        return transposed;
+}
+
+void StepProcessor::playNote(
+    const TrackInfo& trackInfo,
+    const uint8_t note,
+    const uint8_t velocity,
+    const int onTick,
+    const int offTick,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut)
+{
+    const uint8_t channel = trackInfo.midiChannel;
+    midiOut.addEvent(juce::MidiMessage::noteOn(channel, note, velocity), timing.tickToSampleOffset(onTick));
+
+    // Notes that outlast the block are released by a later processNoteOffs()
+    if (timing.contains(offTick))
+        midiOut.addEvent(juce::MidiMessage::noteOff(channel, note), timing.tickToSampleOffset(offTick));
+    else
+        queueNoteOff(trackInfo.id, channel, note, offTick, timing, midiOut);
+}
+
+void StepProcessor::queueNoteOff(
+    const uint32_t trackId,
+    const uint8_t channel,
+    const uint8_t note,
+    const int tick,
+    const BlockTiming& timing,
+    MidiEventQueue& midiOut)
+{
+    if (numPendingNoteOffs >= pendingNoteOffs.size())
+    {
+        // Cut the note short at the end of the block rather than let it hang
+        midiOut.addEvent(juce::MidiMessage::noteOff(channel, note), std::max(0, timing.numSamples - 1));
+        return;
+    }
+
+    pendingNoteOffs[numPendingNoteOffs++] = PendingNoteOff{tick, trackId, channel, note};
+}
+
 } // namespace Sirkus::Core
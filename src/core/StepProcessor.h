@@ -1,42 +1,140 @@
 #pragma once
 
-#include "Scale.h"
+#include "BlockTiming.h"
+#include "MidiEventQueue.h"
+#include "ScaleTable.h"
 #include "Types.h"
+#include "../Constants.h"
 #include "../JuceHeader.h"
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 namespace Sirkus::Core {
 
 // Forward declarations
+class Arpeggiator;
 class Track;
 class Step;
 
+/*
+Turns a track's steps into notes.
+
+Note-offs that land in a later block are kept in a list sized by prepare() and sent
+from processNoteOffs() once their block comes round, or all at once by flushNoteOffs()
+when the transport stops or jumps.
+*/
 class StepProcessor
 {
 public:
+    static constexpr size_t PENDING_NOTE_OFFS_PER_TRACK = 16;
+
+    // The longest note a step can hold, and so how far back a chase has to look
+    static constexpr int CHASE_WINDOW_TICKS = Constants::STEP_FOUR_BARS;
+
     StepProcessor();
     ~StepProcessor();
 
-    // Process steps and generate MIDI output
+    // Size the pending note-off list for this many tracks. Not while processing
+    void prepare(size_t maxTracks);
+
+    // Process steps and generate MIDI output. When an arpeggiator is given the
+    // resulting notes are handed to it instead of being written to midiOut
     void processSteps(
-        const std::vector<std::pair<int, const Step*>>& steps,
+        const std::vector<ActiveStep>& steps,
+        const TrackInfo& trackInfo,
+        const ScaleTable& scale,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut,
+        Arpeggiator* arpeggiator = nullptr);
+
+    // Restart the notes that would still be sounding at the start of the block.
+    // steps are those triggered in the CHASE_WINDOW_TICKS before it
+    void chaseSteps(
+        const std::vector<ActiveStep>& steps,
         const TrackInfo& trackInfo,
-        const Scale& scale,
-        int startTick,
-        int numTicks,
-        juce::MidiBuffer& midiOut);
+        const ScaleTable& scale,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut,
+        Arpeggiator* arpeggiator = nullptr);
+
+    // Send the note-offs that fall in this block. Call before processSteps()
+    void processNoteOffs(const BlockTiming& timing, MidiEventQueue& midiOut);
+
+    // Send every outstanding note-off now
+    void flushNoteOffs(MidiEventQueue& midiOut, int sampleOffset = 0);
+
+    // Send the outstanding note-offs of one track now, when it is muted
+    void flushTrackNoteOffs(uint32_t trackId, MidiEventQueue& midiOut, int sampleOffset);
 
 private:
-    // Helper methods
-    static void processStep(
-        const Step& step,
+    struct PendingNoteOff
+    {
+        int tick;
+        uint32_t trackId;
+        uint8_t channel;
+        uint8_t note;
+    };
+
+    // A loop over a block's steps with the track's configuration fixed at compile time: chase
+    // or play, the scale mode, whether probability is rolled and where the notes go. Picked
+    // once per track per block, so nothing inside the loop branches on configuration.
+    // Steps have no ratchets or parameter locks yet, so there is nothing for the kernel to
+    // specialise on for them. Either would be another template parameter here when added
+    using Kernel = void (StepProcessor::*)(
+        const std::vector<ActiveStep>&,
+        const TrackInfo&,
+        const ScaleTable&,
+        const BlockTiming&,
+        MidiEventQueue&,
+        Arpeggiator*);
+
+    template <bool chase, ScaleMode scaleMode, bool useProbability, bool toArpeggiator>
+    void runKernel(
+        const std::vector<ActiveStep>& steps,
         const TrackInfo& trackInfo,
-        const Scale& scale,
-        int triggerTick,
-        int startTick,
-        int numTicks,
-        juce::MidiBuffer& midiOut);
+        const ScaleTable& scale,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut,
+        Arpeggiator* arpeggiator);
+
+    static Kernel selectKernel(bool chase, const TrackInfo& trackInfo, bool useProbability, bool toArpeggiator);
+    template <bool chase>
+    static Kernel selectKernel(ScaleMode scaleMode, bool useProbability, bool toArpeggiator);
+    template <bool chase, ScaleMode scaleMode>
+    static Kernel selectKernel(bool useProbability, bool toArpeggiator);
+
+    // Whether any step, or the track, can skip a trigger. If not the kernel never rolls
+    static bool needsProbability(const std::vector<ActiveStep>& steps, const TrackInfo& trackInfo);
+
+    // The random bits for a trigger, hashed from the track and where the trigger is written
+    // like Humanize's. A chase makes the same choices as the playthrough it stands in for,
+    // and a render makes the same ones every time
+    static uint64_t triggerBits(uint32_t trackId, int triggerTick);
+
+    void playNote(
+        const TrackInfo& trackInfo,
+        uint8_t note,
+        uint8_t velocity,
+        int onTick,
+        int offTick,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut);
+
+    void queueNoteOff(
+        uint32_t trackId,
+        uint8_t channel,
+        uint8_t note,
+        int tick,
+        const BlockTiming& timing,
+        MidiEventQueue& midiOut);
+
+    template <ScaleMode scaleMode>
+    static uint8_t resolveNote(uint8_t note, const TrackInfo& trackInfo, const ScaleTable& scale, uint32_t randomBits);
+
+    std::vector<PendingNoteOff> pendingNoteOffs;
+    size_t numPendingNoteOffs{0};
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepProcessor)
 };
@@ -0,0 +1,288 @@
+#include "TempoMap.h"
+
+#include "../Constants.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Sirkus::Core {
+
+using namespace Sirkus::Constants;
+
+namespace {
+// Ramps flatter than this are treated as constant to keep the closed forms stable
+constexpr double MIN_RAMP_RATE = 1e-12;
+} // namespace
+
+TempoMap::TempoMap()
+{
+    setTempo(120.0);
+    setTimeSignature(4, 4);
+}
+
+void TempoMap::prepare(const double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    rebuildSegments();
+}
+
+void TempoMap::setTempo(const double bpm)
+{
+    tempoEvents[0] = TempoEvent{0, std::clamp(bpm, MIN_BPM, MAX_BPM), TempoRamp::None};
+    numTempoEvents = 1;
+    rebuildSegments();
+}
+
+bool TempoMap::addTempoEvent(const int64_t tick, const double bpm, const TempoRamp rampToNext)
+{
+    if (tick < 0)
+        return false;
+
+    const TempoEvent event{tick, std::clamp(bpm, MIN_BPM, MAX_BPM), rampToNext};
+    const auto end = tempoEvents.begin() + static_cast<std::ptrdiff_t>(numTempoEvents);
+    const auto it = std::lower_bound(
+        tempoEvents.begin(),
+        end,
+        tick,
+        [](const TempoEvent& existing, const int64_t t) { return existing.tick < t; });
+
+    if (it != end && it->tick == tick)
+    {
+        *it = event;
+    }
+    else
+    {
+        if (numTempoEvents >= MAX_TEMPO_EVENTS)
+            return false;
+
+        std::move_backward(it, end, end + 1);
+        *it = event;
+        ++numTempoEvents;
+    }
+
+    rebuildSegments();
+    return true;
+}
+
+void TempoMap::setTimeSignature(const int numerator, const int denominator)
+{
+    meterEvents[0] = MeterEvent{1, std::max(numerator, 1), std::max(denominator, 1)};
+    numMeterEvents = 1;
+}
+
+bool TempoMap::addMeterEvent(const int bar, const int numerator, const int denominator)
+{
+    if (bar < 1)
+        return false;
+
+    const MeterEvent event{bar, std::max(numerator, 1), std::max(denominator, 1)};
+    const auto end = meterEvents.begin() + static_cast<std::ptrdiff_t>(numMeterEvents);
+    const auto it = std::lower_bound(
+        meterEvents.begin(),
+        end,
+        bar,
+        [](const MeterEvent& existing, const int b) { return existing.bar < b; });
+
+    if (it != end && it->bar == bar)
+    {
+        *it = event;
+        return true;
+    }
+
+    if (numMeterEvents >= MAX_METER_EVENTS)
+        return false;
+
+    std::move_backward(it, end, end + 1);
+    *it = event;
+    ++numMeterEvents;
+    return true;
+}
+
+double TempoMap::tickToSample(const double tick, size_t& segmentHint) const
+{
+    segmentHint = findSegmentByTick(tick, segmentHint);
+    const auto& segment = segments[segmentHint];
+    return segment.startSample + segmentSamples(segment, tick - segment.startTick);
+}
+
+double TempoMap::sampleToTick(const double sample, size_t& segmentHint) const
+{
+    segmentHint = findSegmentBySample(sample, segmentHint);
+    const auto& segment = segments[segmentHint];
+    return segment.startTick + segmentTicks(segment, sample - segment.startSample);
+}
+
+double TempoMap::getBpmAtTick(const double tick) const
+{
+    const auto& segment = segments[findSegmentByTick(tick, 0)];
+    const double ticks = std::max(tick - segment.startTick, 0.0);
+
+    switch (segment.ramp)
+    {
+        case TempoRamp::Linear:
+            return segment.startBpm + segment.rate * ticks;
+        case TempoRamp::Exponential:
+            return segment.startBpm * std::exp(segment.rate * ticks);
+        case TempoRamp::None:
+        default:
+            return segment.startBpm;
+    }
+}
+
+std::pair<int, int> TempoMap::getTimeSignatureAtTick(const double tick) const
+{
+    size_t index = 0;
+    while (index + 1 < numMeterEvents && static_cast<double>(barToTick(meterEvents[index + 1].bar)) <= tick)
+        ++index;
+
+    return {meterEvents[index].numerator, meterEvents[index].denominator};
+}
+
+MusicalPosition TempoMap::getMusicalPosition(const double tick) const
+{
+    // Walk the meter changes to the one in force, counting bars as we go
+    size_t index = 0;
+    int64_t meterStartTick = 0;
+    while (index + 1 < numMeterEvents)
+    {
+        const int64_t nextTick = meterStartTick +
+            static_cast<int64_t>(meterEvents[index + 1].bar - meterEvents[index].bar) * ticksPerBar(meterEvents[index]);
+        if (static_cast<double>(nextTick) > tick)
+            break;
+
+        meterStartTick = nextTick;
+        ++index;
+    }
+
+    const auto& meter = meterEvents[index];
+    const double ticksPerBeat = static_cast<double>(PPQN) * 4.0 / meter.denominator;
+    const double beats = std::max(tick - static_cast<double>(meterStartTick), 0.0) / ticksPerBeat;
+
+    MusicalPosition position;
+    position.bar = meter.bar + static_cast<int>(beats / meter.numerator);
+    position.beat = static_cast<int>(std::fmod(beats, meter.numerator)) + 1;
+    position.tick = std::fmod(beats, 1.0) * PPQN;
+    return position;
+}
+
+int64_t TempoMap::barToTick(const int bar) const
+{
+    int64_t tick = 0;
+    for (size_t i = 0; i < numMeterEvents; ++i)
+    {
+        const bool isLast = i + 1 == numMeterEvents || meterEvents[i + 1].bar > bar;
+        const int barsInMeter = (isLast ? bar : meterEvents[i + 1].bar) - meterEvents[i].bar;
+        tick += static_cast<int64_t>(barsInMeter) * ticksPerBar(meterEvents[i]);
+        if (isLast)
+            break;
+    }
+    return tick;
+}
+
+void TempoMap::rebuildSegments()
+{
+    samplesPerTickAtOneBpm = 60.0 * sampleRate / PPQN;
+
+    double startSample = 0.0;
+    for (size_t i = 0; i < numTempoEvents; ++i)
+    {
+        const auto& event = tempoEvents[i];
+        auto& segment = segments[i];
+        segment = Segment{static_cast<double>(event.tick), startSample, event.bpm, 0.0, TempoRamp::None};
+
+        if (i + 1 == numTempoEvents)
+            break;
+
+        // Ramps need somewhere to go, so only segments with a following event have one
+        const auto& next = tempoEvents[i + 1];
+        const auto length = static_cast<double>(next.tick - event.tick);
+        if (event.rampToNext == TempoRamp::Linear)
+        {
+            segment.rate = (next.bpm - event.bpm) / length;
+            segment.ramp = std::abs(segment.rate) > MIN_RAMP_RATE ? TempoRamp::Linear : TempoRamp::None;
+        }
+        else if (event.rampToNext == TempoRamp::Exponential)
+        {
+            segment.rate = std::log(next.bpm / event.bpm) / length;
+            segment.ramp = std::abs(segment.rate) > MIN_RAMP_RATE ? TempoRamp::Exponential : TempoRamp::None;
+        }
+
+        startSample += segmentSamples(segment, length);
+    }
+}
+
+size_t TempoMap::findSegmentByTick(const double tick, const size_t hint) const
+{
+    const auto contains = [this, tick](const size_t i) {
+        return (i == 0 || segments[i].startTick <= tick) &&
+            (i + 1 == numTempoEvents || tick < segments[i + 1].startTick);
+    };
+
+    if (hint < numTempoEvents && contains(hint))
+        return hint;
+    if (hint + 1 < numTempoEvents && contains(hint + 1))
+        return hint + 1;
+
+    const auto end = segments.begin() + static_cast<std::ptrdiff_t>(numTempoEvents);
+    const auto it = std::upper_bound(
+        segments.begin() + 1,
+        end,
+        tick,
+        [](const double t, const Segment& segment) { return t < segment.startTick; });
+    return static_cast<size_t>(it - segments.begin()) - 1;
+}
+
+size_t TempoMap::findSegmentBySample(const double sample, const size_t hint) const
+{
+    const auto contains = [this, sample](const size_t i) {
+        return (i == 0 || segments[i].startSample <= sample) &&
+            (i + 1 == numTempoEvents || sample < segments[i + 1].startSample);
+    };
+
+    if (hint < numTempoEvents && contains(hint))
+        return hint;
+    if (hint + 1 < numTempoEvents && contains(hint + 1))
+        return hint + 1;
+
+    const auto end = segments.begin() + static_cast<std::ptrdiff_t>(numTempoEvents);
+    const auto it = std::upper_bound(
+        segments.begin() + 1,
+        end,
+        sample,
+        [](const double s, const Segment& segment) { return s < segment.startSample; });
+    return static_cast<size_t>(it - segments.begin()) - 1;
+}
+
+double TempoMap::segmentSamples(const Segment& segment, const double ticks) const
+{
+    const double k = samplesPerTickAtOneBpm;
+
+    // Before the start of the map the first tempo simply extends backwards
+    if (ticks <= 0.0 || segment.ramp == TempoRamp::None)
+        return ticks * k / segment.startBpm;
+
+    if (segment.ramp == TempoRamp::Linear)
+        return k / segment.rate * std::log1p(segment.rate * ticks / segment.startBpm);
+
+    return k / (segment.startBpm * segment.rate) * -std::expm1(-segment.rate * ticks);
+}
+
+double TempoMap::segmentTicks(const Segment& segment, const double samples) const
+{
+    const double k = samplesPerTickAtOneBpm;
+
+    if (samples <= 0.0 || segment.ramp == TempoRamp::None)
+        return samples * segment.startBpm / k;
+
+    if (segment.ramp == TempoRamp::Linear)
+        return segment.startBpm / segment.rate * std::expm1(samples * segment.rate / k);
+
+    return -std::log1p(-samples * segment.startBpm * segment.rate / k) / segment.rate;
+}
+
+int64_t TempoMap::ticksPerBar(const MeterEvent& meter)
+{
+    return static_cast<int64_t>(PPQN) * 4 * meter.numerator / meter.denominator;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "TimingInfo.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace Sirkus::Core {
+
+enum class TempoRamp
+{
+    None,       // Jump to the next tempo when its event is reached
+    Linear,     // Tempo moves in a straight line towards the next event
+    Exponential // Tempo changes by a constant ratio per tick towards the next event
+};
+
+struct TempoEvent
+{
+    int64_t tick{0};
+    double bpm{120.0};
+    TempoRamp rampToNext{TempoRamp::None};
+};
+
+struct MeterEvent
+{
+    int bar{1}; // Meter changes always start a bar
+    int numerator{4};
+    int denominator{4};
+};
+
+/*
+Tempo and time signature changes along the tick timeline.
+
+Tempo events are turned into segments that each know the sample they start on, so
+converting a tick to a sample (or back) is a segment lookup followed by a closed-form
+expression, including inside linear and exponential ramps. Lookups accept the index of
+the segment used last time, which almost always still holds for the next event in
+the same block.
+
+Everything is stored in fixed-size arrays, so a map can be copied between threads
+without allocating.
+*/
+class TempoMap
+{
+public:
+    static constexpr size_t MAX_TEMPO_EVENTS = 64;
+    static constexpr size_t MAX_METER_EVENTS = 32;
+    static constexpr double MIN_BPM = 1.0;
+    static constexpr double MAX_BPM = 999.0;
+
+    TempoMap();
+
+    void prepare(double sampleRate);
+
+    // Editing, message thread. Events at an existing position replace it
+    void setTempo(double bpm);
+    bool addTempoEvent(int64_t tick, double bpm, TempoRamp rampToNext = TempoRamp::None);
+    void setTimeSignature(int numerator, int denominator);
+    bool addMeterEvent(int bar, int numerator, int denominator);
+
+    [[nodiscard]] size_t getNumTempoEvents() const { return numTempoEvents; }
+    [[nodiscard]] const TempoEvent& getTempoEvent(size_t index) const { return tempoEvents[index]; }
+    [[nodiscard]] size_t getNumMeterEvents() const { return numMeterEvents; }
+    [[nodiscard]] const MeterEvent& getMeterEvent(size_t index) const { return meterEvents[index]; }
+
+    // A single tempo with no ramps, which the transport can follow with exact integer maths
+    [[nodiscard]] bool isConstant() const { return numTempoEvents == 1; }
+
+    // Conversions. The hint is the segment index to try first, it is updated in place
+    [[nodiscard]] double tickToSample(double tick, size_t& segmentHint) const;
+    [[nodiscard]] double sampleToTick(double sample, size_t& segmentHint) const;
+    [[nodiscard]] double getBpmAtTick(double tick) const;
+
+    [[nodiscard]] std::pair<int, int> getTimeSignatureAtTick(double tick) const;
+    [[nodiscard]] MusicalPosition getMusicalPosition(double tick) const;
+    [[nodiscard]] int64_t barToTick(int bar) const;
+
+private:
+    struct Segment
+    {
+        double startTick;
+        double startSample;
+        double startBpm;
+        double rate; // Linear: bpm per tick. Exponential: log of the tempo ratio per tick
+        TempoRamp ramp;
+    };
+
+    void rebuildSegments();
+    [[nodiscard]] size_t findSegmentByTick(double tick, size_t hint) const;
+    [[nodiscard]] size_t findSegmentBySample(double sample, size_t hint) const;
+    [[nodiscard]] double segmentSamples(const Segment& segment, double ticks) const;
+    [[nodiscard]] double segmentTicks(const Segment& segment, double samples) const;
+    [[nodiscard]] static int64_t ticksPerBar(const MeterEvent& meter);
+
+    double sampleRate{44100.0};
+    double samplesPerTickAtOneBpm{0.0};
+
+    std::array<TempoEvent, MAX_TEMPO_EVENTS> tempoEvents{};
+    size_t numTempoEvents{0};
+    std::array<MeterEvent, MAX_METER_EVENTS> meterEvents{};
+    size_t numMeterEvents{0};
+    std::array<Segment, MAX_TEMPO_EVENTS> segments{};
+};
+
+} // namespace Sirkus::Core
@@ -7,33 +7,51 @@ namespace Sirkus::Core {
 
 using namespace Sirkus::Constants;
 
+void TimingInfo::setPpqPosition(const double ppq)
+{
+    ppqPosition = ppq;
+    validFields |= HAS_PPQ_POSITION;
+}
+
+void TimingInfo::setBpm(const double newBpm)
+{
+    bpm = newBpm;
+    validFields |= HAS_BPM;
+}
+
+void TimingInfo::setMusicalPosition(const MusicalPosition& position)
+{
+    musicalPosition = position;
+    validFields |= HAS_MUSICAL_POSITION;
+}
+
+void TimingInfo::setTimeSignature(const int numerator, const int denominator)
+{
+    timeSigNumerator = static_cast<int16_t>(numerator);
+    timeSigDenominator = static_cast<int16_t>(denominator);
+    validFields |= HAS_TIME_SIGNATURE;
+}
+
 TimingInfo TimingInfo::fromPositionInfo(const juce::AudioPlayHead::PositionInfo& pos)
 {
     TimingInfo info;
 
     if (auto ppq = pos.getPpqPosition())
-        info.ppqPosition = *ppq;
+        info.setPpqPosition(*ppq);
 
     if (auto tempo = pos.getBpm())
-        info.bpm = *tempo;
+        info.setBpm(*tempo);
 
     if (auto timeSig = pos.getTimeSignature())
-        info.timeSignature = std::make_pair(timeSig->numerator, timeSig->denominator);
+        info.setTimeSignature(timeSig->numerator, timeSig->denominator);
 
     info.isPlaying = pos.getIsPlaying();
 
     // Calculate musical position if we have PPQ and time signature
-    if (info.ppqPosition && info.timeSignature)
+    if (info.has(HAS_PPQ_POSITION | HAS_TIME_SIGNATURE))
     {
-        MusicalPosition position;
-        const double beatsPerBar = info.timeSignature->first * (4.0 / info.timeSignature->second);
-        const double totalBeats = *info.ppqPosition * (info.timeSignature->second / 4.0);
-
-        position.bar = static_cast<int>(totalBeats / beatsPerBar) + 1;
-        position.beat = static_cast<int>(std::fmod(totalBeats, beatsPerBar)) + 1;
-        position.tick = std::fmod(totalBeats, 1.0) * PPQN;
-
-        info.musicalPosition = position;
+        info.setMusicalPosition(
+            calculateMusicalPosition(info.ppqPosition, info.timeSigNumerator, info.timeSigDenominator));
     }
 
     return info;
@@ -43,4 +61,36 @@ TimingInfo TimingInfo::fromInternalTransport(const InternalTransport& transport)
 {
     return transport.getTimingInfo();
 }
+
+TimingInfo TimingInfo::fromMidiClock(
+    const double ppqPosition,
+    const double bpm,
+    const bool isPlaying,
+    const int numerator,
+    const int denominator)
+{
+    TimingInfo info;
+    info.setPpqPosition(ppqPosition);
+    info.setBpm(bpm);
+    info.setTimeSignature(numerator, denominator);
+    info.setMusicalPosition(calculateMusicalPosition(ppqPosition, numerator, denominator));
+    info.isPlaying = isPlaying;
+    return info;
+}
+
+MusicalPosition TimingInfo::calculateMusicalPosition(
+    const double ppqPosition,
+    const int numerator,
+    const int denominator)
+{
+    MusicalPosition position;
+    const double beatsPerBar = numerator * (4.0 / denominator);
+    const double totalBeats = ppqPosition * (denominator / 4.0);
+
+    position.bar = static_cast<int>(totalBeats / beatsPerBar) + 1;
+    position.beat = static_cast<int>(std::fmod(totalBeats, beatsPerBar)) + 1;
+    position.tick = std::fmod(totalBeats, 1.0) * PPQN;
+
+    return position;
+}
 } // namespace Sirkus::Core
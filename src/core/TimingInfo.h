@@ -2,7 +2,7 @@
 
 #include "../JuceHeader.h"
 #include <cmath>
-#include <optional>
+#include <cstdint>
 #include <utility>
 
 namespace Sirkus::Core {
@@ -22,16 +22,41 @@ struct MusicalPosition
 
 class InternalTransport; // Forward declaration
 
+/*
+Timing for one block. A plain value with a bit per field saying whether the source
+provided it, so it can be copied between threads as a handful of words.
+*/
 struct TimingInfo
 {
-    std::optional<double> ppqPosition;
-    std::optional<double> bpm;
-    std::optional<MusicalPosition> musicalPosition;
-    std::optional<std::pair<int, int>> timeSignature;
+    // Bits of validFields
+    static constexpr uint8_t HAS_PPQ_POSITION = 1 << 0;
+    static constexpr uint8_t HAS_BPM = 1 << 1;
+    static constexpr uint8_t HAS_MUSICAL_POSITION = 1 << 2;
+    static constexpr uint8_t HAS_TIME_SIGNATURE = 1 << 3;
+
+    double ppqPosition = 0.0;
+    double bpm = 0.0;
+    MusicalPosition musicalPosition;
+    int16_t timeSigNumerator = 4;
+    int16_t timeSigDenominator = 4;
+    uint8_t validFields = 0;
     bool isPlaying = false;
 
+    [[nodiscard]] bool has(const uint8_t fields) const { return (validFields & fields) == fields; }
+
+    void setPpqPosition(double ppq);
+    void setBpm(double newBpm);
+    void setMusicalPosition(const MusicalPosition& position);
+    void setTimeSignature(int numerator, int denominator);
+
     static TimingInfo fromPositionInfo(const juce::AudioPlayHead::PositionInfo& pos);
     static TimingInfo fromInternalTransport(const InternalTransport& transport);
-} __attribute__((aligned(128)));
+
+    // MIDI clock carries no meter, the caller supplies one
+    static TimingInfo fromMidiClock(double ppqPosition, double bpm, bool isPlaying, int numerator, int denominator);
+
+private:
+    static MusicalPosition calculateMusicalPosition(double ppqPosition, int numerator, int denominator);
+};
 
 } // namespace Sirkus::Core
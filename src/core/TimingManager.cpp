@@ -1,5 +1,9 @@
 #include "TimingManager.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
 namespace Sirkus::Core {
 TimingManager::TimingManager()
     : standaloneMode(false)
@@ -7,19 +11,58 @@ TimingManager::TimingManager()
 {
 }
 
-void TimingManager::prepare(const double sampleRate)
+void TimingManager::prepare(const double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    internalTransport.prepare(newSampleRate);
+    midiClockInput.prepare(newSampleRate);
+    continuesPreviousBlock = false;
+    wasPlaying = false;
+}
+
+void TimingManager::processBlock(
+    const juce::AudioPlayHead* playHead,
+    const int numSamples,
+    const juce::MidiBuffer& midiIn)
 {
-    internalTransport.prepare(sampleRate);
+    // Clock is followed every block, so the tempo estimate is settled by the time it's used
+    midiClockInput.processBlock(midiIn, numSamples);
+
+    updateTiming(playHead, numSamples);
+
+    const int latency = getLatencySamples();
+    engineTiming = latency > 0 ? blockTiming.delayedBy(latency) : blockTiming;
+    detectDiscontinuity();
+
+    // Readers on other threads only ever see a complete block's timing
+    publishedTiming.store(currentTiming);
 }
 
-void TimingManager::processBlock(const juce::AudioPlayHead* playHead, const int numSamples)
+void TimingManager::updateTiming(const juce::AudioPlayHead* playHead, const int numSamples)
 {
-    if (playHead != nullptr && hostSyncEnabled)
+    if (isMidiClockSyncEnabled() && midiClockInput.isReceiving())
+    {
+        standaloneMode = true;
+        activeSource = TimingSource::MidiClock;
+        const auto& meter = internalTransport.getTimingInfo();
+        currentTiming = TimingInfo::fromMidiClock(
+            midiClockInput.getPpqPosition(),
+            midiClockInput.getBpm(),
+            midiClockInput.isPlaying(),
+            meter.timeSigNumerator,
+            meter.timeSigDenominator);
+        updateBlockTimingFromPpq(numSamples);
+        return;
+    }
+
+    if (playHead != nullptr && isHostSyncEnabled())
     {
         if (auto pos = playHead->getPosition(); pos->getPpqPosition().hasValue() && pos->getBpm().hasValue())
         {
             standaloneMode = false;
+            activeSource = TimingSource::Host;
             currentTiming = TimingInfo::fromPositionInfo(*pos);
+            updateBlockTimingFromPpq(numSamples);
             return;
         }
     }
@@ -28,28 +71,44 @@ void TimingManager::processBlock(const juce::AudioPlayHead* playHead, const int
     // - No host is available
     // - Host sync is disabled
     // - Host doesn't provide required timing info
+    // The internal transport reports the start of the block, like a host does
     standaloneMode = true;
+    activeSource = TimingSource::Internal;
     internalTransport.processBlock(numSamples);
     currentTiming = TimingInfo::fromInternalTransport(internalTransport);
+    blockTiming = internalTransport.getBlockTiming();
+    continuesPreviousBlock = currentTiming.isPlaying;
 }
 
-std::optional<double> TimingManager::getPpqPosition() const
+void TimingManager::updateBlockTimingFromPpq(const int numSamples)
 {
-    return currentTiming.ppqPosition;
-}
+    // The host's last block, not the delayed engine block detectDiscontinuity() compares against
+    const int64_t previousHostEndTick = blockTiming.endTick;
+    blockTiming = BlockTiming::fromPpq(currentTiming.ppqPosition, currentTiming.bpm, sampleRate, numSamples);
 
-std::optional<double> TimingManager::getBpm() const
-{
-    return currentTiming.bpm;
+    // Floating point positions wobble by a fraction of a tick between blocks. Pick up
+    // exactly where the last block ended so no tick is played twice or skipped
+    if (continuesPreviousBlock && std::abs(blockTiming.startTick - previousHostEndTick) <= 1)
+        blockTiming.startTick = std::min(previousHostEndTick, blockTiming.endTick);
+
+    continuesPreviousBlock = currentTiming.isPlaying;
 }
 
-std::optional<MusicalPosition> TimingManager::getMusicalPosition() const
+int TimingManager::getLatencySamples() const
 {
-    return currentTiming.musicalPosition;
+    return static_cast<int>(std::lround(getLookaheadMs() * sampleRate / 1000.0));
 }
 
-std::optional<std::pair<int, int>> TimingManager::getTimeSignature() const
+void TimingManager::detectDiscontinuity()
 {
-    return currentTiming.timeSignature;
+    // Positions from the host are already snapped onto the previous block, so any
+    // difference left over is a real jump
+    const bool playing = currentTiming.isPlaying;
+    startedPlaying = playing && !wasPlaying;
+    jumped = playing && wasPlaying && engineTiming.startTick != previousEndTick;
+
+    wasPlaying = playing;
+    previousEndTick = engineTiming.endTick;
 }
+
 } // namespace Sirkus::Core
@@ -1,31 +1,73 @@
 #pragma once
 
+#include "BlockTiming.h"
 #include "InternalTransport.h"
+#include "MidiClockInput.h"
+#include "SeqLock.h"
 #include "TimingInfo.h"
 
 #include "../JuceHeader.h"
 
+#include <atomic>
+
 namespace Sirkus::Core {
+
+enum class TimingSource
+{
+    Host,
+    Internal,
+    MidiClock
+};
+
 class TimingManager
 {
 public:
     TimingManager();
 
     void prepare(double sampleRate);
-    void processBlock(const juce::AudioPlayHead* playHead, int numSamples);
+    void processBlock(const juce::AudioPlayHead* playHead, int numSamples, const juce::MidiBuffer& midiIn);
 
-    // Timing info getters
-    [[nodiscard]] std::optional<double> getPpqPosition() const;
-    [[nodiscard]] std::optional<double> getBpm() const;
-    [[nodiscard]] std::optional<MusicalPosition> getMusicalPosition() const;
-    [[nodiscard]] std::optional<std::pair<int, int>> getTimeSignature() const;
+    // Any thread: a consistent copy of the most recent block's timing
+    [[nodiscard]] TimingInfo getTimingInfo() const { return publishedTiming.load(); }
+
+    // Audio thread: the current block's timing and its exact tick window
+    [[nodiscard]] const TimingInfo& getCurrentTiming() const { return currentTiming; }
+    [[nodiscard]] const BlockTiming& getBlockTiming() const { return blockTiming; }
+
+    // Audio thread: the tick window output is generated for. With lookahead it trails the
+    // host position by the reported latency, so events can be sent before their tick
+    [[nodiscard]] const BlockTiming& getEngineTiming() const { return engineTiming; }
 
     [[nodiscard]] bool isStandaloneMode() const { return standaloneMode; }
+    [[nodiscard]] TimingSource getActiveSource() const { return activeSource; }
+
+    // Audio thread: whether the active timing source is currently playing
+    [[nodiscard]] bool isTransportPlaying() const { return currentTiming.isPlaying; }
+
+    // Audio thread: playback started with this block, or it doesn't pick up where the
+    // previous block ended because the host looped or relocated. Both follow the engine timing
+    [[nodiscard]] bool hasStartedPlaying() const { return startedPlaying; }
+    [[nodiscard]] bool hasJumped() const { return jumped; }
 
     // Host sync control
-    void setHostSyncEnabled(bool enabled) { hostSyncEnabled = enabled; }
+    void setHostSyncEnabled(bool enabled) { hostSyncEnabled.store(enabled, std::memory_order_relaxed); }
 
-    [[nodiscard]] bool isHostSyncEnabled() const { return hostSyncEnabled; }
+    [[nodiscard]] bool isHostSyncEnabled() const { return hostSyncEnabled.load(std::memory_order_relaxed); }
+
+    // External MIDI clock sync. While clock is arriving it takes priority over the host
+    void setMidiClockSyncEnabled(bool enabled) { midiClockSyncEnabled.store(enabled, std::memory_order_relaxed); }
+
+    [[nodiscard]] bool isMidiClockSyncEnabled() const { return midiClockSyncEnabled.load(std::memory_order_relaxed); }
+
+    MidiClockInput& getMidiClockInput() { return midiClockInput; }
+
+    // Lookahead, 0 turns it off. The plugin reports getLatencySamples() to the host, which
+    // shifts the output back into place
+    static constexpr double MAX_LOOKAHEAD_MS = 100.0;
+
+    void setLookaheadMs(double ms) { lookaheadMs.store(juce::jlimit(0.0, MAX_LOOKAHEAD_MS, ms), std::memory_order_relaxed); }
+    [[nodiscard]] double getLookaheadMs() const { return lookaheadMs.load(std::memory_order_relaxed); }
+    [[nodiscard]] int getLatencySamples() const;
 
     // Transport control methods
     void setBpm(double newBpm) { internalTransport.setBpm(newBpm); }
@@ -35,6 +77,11 @@ public:
         internalTransport.setTimeSignature(numerator, denominator);
     }
 
+    // Tempo and meter changes with ramps, followed sample-accurately by the internal transport
+    void setTempoMap(const TempoMap& tempoMap) { internalTransport.setTempoMap(tempoMap); }
+
+    [[nodiscard]] const TempoMap& getTempoMap() const { return internalTransport.getTempoMap(); }
+
     void start() { internalTransport.start(); }
 
     void stop() { internalTransport.stop(); }
@@ -48,10 +95,27 @@ public:
 
 private:
     InternalTransport internalTransport;
+    MidiClockInput midiClockInput;
     bool standaloneMode;
-    bool hostSyncEnabled = true; // Default to syncing with host when available
+    std::atomic<bool> hostSyncEnabled{true}; // Default to syncing with host when available
+    std::atomic<bool> midiClockSyncEnabled{false};
+    TimingSource activeSource = TimingSource::Internal;
     TimingInfo currentTiming;
-
-    void updateHostPositionInfo(const juce::AudioPlayHead::PositionInfo& pos);
+    SeqLock<TimingInfo> publishedTiming;
+    BlockTiming blockTiming;
+    BlockTiming engineTiming;
+    std::atomic<double> lookaheadMs{0.0};
+    double sampleRate{44100.0};
+    bool continuesPreviousBlock{false};
+
+    // Discontinuity tracking, compared against the previous block's tick window
+    bool wasPlaying{false};
+    int64_t previousEndTick{0};
+    bool startedPlaying{false};
+    bool jumped{false};
+
+    void updateTiming(const juce::AudioPlayHead* playHead, int numSamples);
+    void updateBlockTimingFromPpq(int numSamples);
+    void detectDiscontinuity();
 };
 } // namespace Sirkus::Core
@@ -11,16 +11,16 @@ namespace Sirkus::Core {
 
 Track::Track(ValueTree parentState, UndoManager& undoManagerToUse, uint32_t id)
     : ValueTreeObject(parentState, ID::track, undoManagerToUse)
-      , props{}
 {
     setProperty(props.trackId, id);
     // Create initial pattern
     ensurePatternExists();
+    publishSettings();
 }
 
 void Track::ensurePatternExists()
 {
-    currentPattern = std::make_unique<Pattern>(state, undoManager);
+    currentPattern = std::make_shared<Pattern>(state, undoManager);
 }
 
 Pattern& Track::getCurrentPattern() const
@@ -28,31 +28,72 @@ Pattern& Track::getCurrentPattern() const
     return *currentPattern;
 }
 
-std::vector<std::pair<int, const Step*>> Track::getActiveSteps(int startTick, int numTicks) const
+const std::shared_ptr<Pattern>& Track::getSharedPattern() const
 {
-    std::vector<std::pair<int, const Step*>> activeSteps;
-    // const Pattern& patternRef = getCurrentPattern();
-    const auto& triggers = getCurrentPattern().getTriggerMap();
+    return currentPattern;
+}
 
-    // Find first trigger at or after startTick
-    auto it = triggers.lower_bound(startTick);
+void Track::linkPattern(std::shared_ptr<Pattern> pattern)
+{
+    jassert(pattern != nullptr);
+    currentPattern = std::move(pattern);
+}
 
-    // Collect all triggers within this block
-    while (it != triggers.end() && it->first < startTick + numTicks)
-    {
-        const auto stepIndex = it->second;
-        auto& step = getCurrentPattern().getStep(stepIndex);
+void Track::unlinkPattern()
+{
+    currentPattern = std::make_shared<Pattern>(state, undoManager, *currentPattern);
+}
 
-        // Only include enabled steps
-        if (step.isEnabled())
-        {
-            activeSteps.emplace_back(it->first, &step);
-        }
+bool Track::holdsPatternTree() const
+{
+    return currentPattern->isChildOf(state);
+}
 
-        ++it;
-    }
+void Track::takePatternTree()
+{
+    currentPattern->moveTree(state);
+}
 
-    return activeSteps;
+void Track::dropPatternTree()
+{
+    currentPattern->moveTree({});
+}
+
+void Track::publishSettings()
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    const auto arp = getArpSettings();
+    const auto humanize = getHumanizeSettings();
+
+    engineId.store(getId(), relaxed);
+    engineMidiChannel.store(getMidiChannel(), relaxed);
+    engineScaleMode.store(getScaleMode(), relaxed);
+    engineArpMode.store(arp.mode, relaxed);
+    engineArpSource.store(arp.source, relaxed);
+    engineArpOctaves.store(arp.octaves, relaxed);
+    engineArpRate.store(arp.rate, relaxed);
+    engineHumanizeTiming.store(humanize.timingTicks, relaxed);
+    engineHumanizeVelocity.store(humanize.velocity, relaxed);
+    engineHumanizeSeed.store(humanize.seed, relaxed);
+    engineKeyboardTranspose.store(getKeyboardTranspose(), relaxed);
+}
+
+Track::EngineSettings Track::getEngineSettings() const
+{
+    // Each value is read on its own. A block that sees half of an edit sees the rest on the next
+    constexpr auto relaxed = std::memory_order_relaxed;
+    return EngineSettings{
+        TrackInfo{engineId.load(relaxed), engineMidiChannel.load(relaxed), engineScaleMode.load(relaxed)},
+        ArpSettings{
+            engineArpMode.load(relaxed),
+            engineArpSource.load(relaxed),
+            engineArpOctaves.load(relaxed),
+            engineArpRate.load(relaxed)},
+        HumanizeSettings{
+            engineHumanizeTiming.load(relaxed),
+            engineHumanizeVelocity.load(relaxed),
+            engineHumanizeSeed.load(relaxed)},
+        engineKeyboardTranspose.load(relaxed)};
 }
 
 } // namespace Sirkus::Core
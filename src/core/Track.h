@@ -1,11 +1,15 @@
 #pragma once
 
 #include "../Identifiers.h"
+#include "Arpeggiator.h"
+#include "Humanize.h"
 #include "Pattern.h"
 #include "Types.h"
 #include "ValueTreeObject.h"
 
 #include "../JuceHeader.h"
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -16,15 +20,59 @@ class Track final : public ValueTreeObject
 public:
     Track(ValueTree parentState, UndoManager& undoManagerToUse, uint32_t id);
 
-    struct Properties
+    struct Schema
     {
-        TypedProperty<uint32_t> trackId{ID::Track::trackId, 0};
-        TypedProperty<uint8_t> midiChannel{ID::Track::midiChannel, 1};
-        TypedProperty<ScaleMode> scaleMode{ID::Track::scaleMode, ScaleMode::Off};
+        static constexpr TypedProperty<uint32_t> trackId{ID::Track::trackId, 0, 0};
+        static constexpr TypedProperty<uint8_t> midiChannel{ID::Track::midiChannel, 1, 1};
+        static constexpr TypedProperty<ScaleMode> scaleMode{ID::Track::scaleMode, ScaleMode::Off, 2};
+        static constexpr TypedProperty<ArpMode> arpMode{ID::Track::arpMode, ArpMode::Off, 3};
+        static constexpr TypedProperty<ArpSource> arpSource{ID::Track::arpSource, ArpSource::Steps, 4};
+        static constexpr TypedProperty<uint8_t> arpOctaves{ID::Track::arpOctaves, 1, 5};
+        static constexpr TypedProperty<TimeDivision> arpRate{ID::Track::arpRate, TimeDivision::SixteenthNote, 6};
+        static constexpr TypedProperty<bool> keyboardTranspose{ID::Track::keyboardTranspose, true, 7};
+        static constexpr TypedProperty<int> humanizeTiming{ID::Track::humanizeTiming, 0, 8};
+        static constexpr TypedProperty<int> humanizeVelocity{ID::Track::humanizeVelocity, 0, 9};
+        static constexpr TypedProperty<int> humanizeSeed{ID::Track::humanizeSeed, 0, 10};
+        static constexpr TypedProperty<bool> mute{ID::Track::mute, false, 11};
+        static constexpr TypedProperty<bool> solo{ID::Track::solo, false, 12};
+        static constexpr size_t NUM_PROPERTIES = 13;
+
+        static int indexOf(const juce::Identifier& id)
+        {
+            return findPropertyIndex(
+                id,
+                trackId,
+                midiChannel,
+                scaleMode,
+                arpMode,
+                arpSource,
+                arpOctaves,
+                arpRate,
+                keyboardTranspose,
+                humanizeTiming,
+                humanizeVelocity,
+                humanizeSeed,
+                mute,
+                solo);
+        }
     };
 
-    // Pattern management
+    static constexpr Schema props{};
+
+    // Pattern management. Linked tracks share one pattern, edited and compiled once
     Pattern& getCurrentPattern() const;
+    const std::shared_ptr<Pattern>& getSharedPattern() const;
+
+    // Message thread, through the Sequencer, which keeps the shared pattern's tree under one
+    // of the tracks that play it. Neither is an edit, and views holding this track's steps
+    // must fetch them again afterwards
+    void linkPattern(std::shared_ptr<Pattern> pattern); // Play pattern instead of the current one
+    void unlinkPattern();                               // Play a copy of the current pattern
+
+    // Whether this track's tree holds its pattern's tree, and moving it here or removing it
+    bool holdsPatternTree() const;
+    void takePatternTree();
+    void dropPatternTree();
 
     // Track properties
     uint32_t getId() const
@@ -53,20 +101,157 @@ public:
         return getProperty(props.scaleMode);
     }
 
-    // Get track information needed for step processing
-    TrackInfo getTrackInfo() const
+    // Arpeggiator settings
+    void setArpMode(ArpMode mode)
+    {
+        setProperty(props.arpMode, mode);
+    }
+
+    ArpMode getArpMode() const
+    {
+        return getProperty(props.arpMode);
+    }
+
+    void setArpSource(ArpSource source)
+    {
+        setProperty(props.arpSource, source);
+    }
+
+    ArpSource getArpSource() const
+    {
+        return getProperty(props.arpSource);
+    }
+
+    void setArpOctaves(uint8_t octaves)
+    {
+        const int clamped = std::clamp<int>(octaves, 1, static_cast<int>(Arpeggiator::MAX_OCTAVES));
+        setProperty(props.arpOctaves, static_cast<uint8_t>(clamped));
+    }
+
+    uint8_t getArpOctaves() const
+    {
+        return getProperty(props.arpOctaves);
+    }
+
+    void setArpRate(TimeDivision rate)
+    {
+        setProperty(props.arpRate, rate);
+    }
+
+    TimeDivision getArpRate() const
+    {
+        return getProperty(props.arpRate);
+    }
+
+    ArpSettings getArpSettings() const
     {
-        return TrackInfo{getId(), getMidiChannel(), getScaleMode()};
+        return ArpSettings{getArpMode(), getArpSource(), getArpOctaves(), getArpRate()};
     }
 
-    // Get active steps for the current tick range
-    std::vector<std::pair<int, const Step*>> getActiveSteps(int startTick, int numTicks) const;
+    // Whether notes on the keyboard control channel transpose this track
+    void setKeyboardTranspose(bool shouldFollow)
+    {
+        setProperty(props.keyboardTranspose, shouldFollow);
+    }
+
+    bool getKeyboardTranspose() const
+    {
+        return getProperty(props.keyboardTranspose);
+    }
+
+    // Groove template for this track's pattern. Changing it recompiles only this track's triggers
+    void setGroove(const Groove& groove)
+    {
+        getCurrentPattern().setGroove(groove);
+    }
+
+    const Groove& getGroove() const
+    {
+        return getCurrentPattern().getGroove();
+    }
+
+    // Humanize: random timing in ticks either way and velocity variation, reproducible per seed
+    void setHumanizeTiming(int ticks)
+    {
+        setProperty(props.humanizeTiming, std::clamp(ticks, 0, HumanizeSettings::MAX_TIMING_TICKS));
+    }
+
+    void setHumanizeVelocity(int amount)
+    {
+        setProperty(props.humanizeVelocity, std::clamp(amount, 0, HumanizeSettings::MAX_VELOCITY));
+    }
+
+    void setHumanizeSeed(int seed)
+    {
+        setProperty(props.humanizeSeed, seed);
+    }
+
+    HumanizeSettings getHumanizeSettings() const
+    {
+        return HumanizeSettings{
+            getProperty(props.humanizeTiming),
+            getProperty(props.humanizeVelocity),
+            static_cast<uint32_t>(getProperty(props.humanizeSeed))};
+    }
+
+    // Mute and solo. The Sequencer passes changes on to the engine, from here or from undo
+    void setMuted(bool shouldBeMuted)
+    {
+        setProperty(props.mute, shouldBeMuted);
+    }
+
+    bool isMuted() const
+    {
+        return getProperty(props.mute);
+    }
+
+    void setSoloed(bool shouldBeSoloed)
+    {
+        setProperty(props.solo, shouldBeSoloed);
+    }
+
+    bool isSoloed() const
+    {
+        return getProperty(props.solo);
+    }
+
+    // Engine-side arpeggiator state, only touched from the audio thread
+    Arpeggiator& getArpeggiator()
+    {
+        return arpeggiator;
+    }
+
+    // What the engine reads of the track every block. The audio thread never touches the tree:
+    // the Sequencer publishes copies from the message thread whenever the track's properties
+    // change, undo and redo included
+    struct EngineSettings
+    {
+        TrackInfo trackInfo;
+        ArpSettings arp;
+        HumanizeSettings humanize;
+        bool keyboardTranspose;
+    };
+
+    void publishSettings();                   // Message thread
+    EngineSettings getEngineSettings() const; // Audio thread
 
 private:
-    Properties props;
+    Arpeggiator arpeggiator;
+
+    std::atomic<uint32_t> engineId{0};
+    std::atomic<uint8_t> engineMidiChannel{1};
+    std::atomic<ScaleMode> engineScaleMode{ScaleMode::Off};
+    std::atomic<ArpMode> engineArpMode{ArpMode::Off};
+    std::atomic<ArpSource> engineArpSource{ArpSource::Steps};
+    std::atomic<uint8_t> engineArpOctaves{1};
+    std::atomic<TimeDivision> engineArpRate{TimeDivision::SixteenthNote};
+    std::atomic<int> engineHumanizeTiming{0};
+    std::atomic<int> engineHumanizeVelocity{0};
+    std::atomic<uint32_t> engineHumanizeSeed{0};
+    std::atomic<bool> engineKeyboardTranspose{true};
 
     void ensurePatternExists();
-    std::unique_ptr<Pattern> currentPattern;
+    std::shared_ptr<Pattern> currentPattern;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Track)
 };
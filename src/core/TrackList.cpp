@@ -0,0 +1,55 @@
+#include "TrackList.h"
+
+#include "Track.h"
+
+namespace Sirkus::Core {
+
+TrackListPublisher::TrackListPublisher()
+    : current(std::make_unique<TrackList>())
+{
+    latest.store(current.get(), std::memory_order_release);
+}
+
+TrackListPublisher::~TrackListPublisher()
+{
+    stopTimer();
+}
+
+void TrackListPublisher::publish(
+    std::vector<Track*> tracks,
+    TriggerTable triggers,
+    const uint64_t silenced,
+    std::vector<std::unique_ptr<Track>> retiredTracks)
+{
+    auto next = std::make_unique<TrackList>();
+    next->epoch = current->epoch + 1;
+    next->tracks = std::move(tracks);
+    next->triggers = std::move(triggers);
+    next->silenced = silenced;
+
+    latest.store(next.get(), std::memory_order_release);
+
+    // The audio thread may still be playing the previous list until it acknowledges this one
+    retired.push_back(Retired{next->epoch, std::move(current), std::move(retiredTracks)});
+    current = std::move(next);
+
+    reclaim();
+}
+
+void TrackListPublisher::reclaim()
+{
+    const uint64_t safeEpoch = acknowledged.load(std::memory_order_acquire);
+    std::erase_if(retired, [safeEpoch](const Retired& entry) { return entry.epoch <= safeEpoch; });
+
+    if (retired.empty())
+        stopTimer();
+    else if (!isTimerRunning())
+        startTimer(RECLAIM_INTERVAL_MS);
+}
+
+void TrackListPublisher::timerCallback()
+{
+    reclaim();
+}
+
+} // namespace Sirkus::Core
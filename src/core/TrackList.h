@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../JuceHeader.h"
+#include "TriggerTable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Sirkus::Core {
+
+class Track;
+
+// The tracks the engine plays, in slot order. Never changed once published
+struct TrackList
+{
+    uint64_t epoch{0};
+    std::vector<Track*> tracks;
+
+    // Each slot's compiled pattern. Linked tracks share one range, compiled once for all of
+    // them. The engine reads triggers only from here, so patterns recompile without waiting
+    TriggerTable triggers;
+
+    uint64_t silenced{0}; // Tracks silenced by mute and solo, one bit per slot
+};
+
+/*
+Hands the engine a new TrackList whenever tracks are added, removed, muted, soloed or
+linked, or a pattern is recompiled.
+
+The message thread builds a complete list and publishes it with one atomic store. At
+the start of each block the audio thread takes the latest list and acknowledges its
+epoch, which means it has finished with every older one. Older lists, and the tracks
+that were removed along with them, are only deleted on the message thread once their
+epoch has been acknowledged. The audio thread never allocates, frees or waits.
+
+Reclamation runs after each publish and on a timer. If the audio thread isn't running,
+retired tracks wait until it is or until the publisher is destroyed.
+*/
+class TrackListPublisher final : private juce::Timer
+{
+public:
+    TrackListPublisher();
+    ~TrackListPublisher() override;
+
+    // Message thread. The tracks in retiredTracks must already be missing from the new list
+    void publish(
+        std::vector<Track*> tracks,
+        TriggerTable triggers,
+        uint64_t silenced,
+        std::vector<std::unique_ptr<Track>> retiredTracks = {});
+    void reclaim();
+
+    // Audio thread: the latest list, which stays valid until acknowledge() is given a newer epoch
+    [[nodiscard]] const TrackList* getLatest() const { return latest.load(std::memory_order_acquire); }
+    void acknowledge(uint64_t epoch) { acknowledged.store(epoch, std::memory_order_release); }
+
+private:
+    void timerCallback() override;
+
+    struct Retired
+    {
+        uint64_t epoch; // Safe to delete once this epoch is acknowledged
+        std::unique_ptr<TrackList> list;
+        std::vector<std::unique_ptr<Track>> tracks;
+    };
+
+    static constexpr int RECLAIM_INTERVAL_MS = 250;
+
+    std::unique_ptr<TrackList> current;
+    std::atomic<const TrackList*> latest{nullptr};
+    std::atomic<uint64_t> acknowledged{0};
+    std::vector<Retired> retired;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackListPublisher)
+};
+
+} // namespace Sirkus::Core
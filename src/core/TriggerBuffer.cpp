@@ -1,49 +1,96 @@
-
-
 #include "TriggerBuffer.h"
 
+#include <algorithm>
+
 namespace Sirkus::Core {
 
 using namespace Sirkus::Constants;
 
-void TriggerBuffer::addStep(int tick, size_t stepIndex)
+void TriggerBuffer::clear()
+{
+    ticks.clear();
+    steps.clear();
+    notes.clear();
+    velocities.clear();
+    velocityOffsets.clear();
+    lengths.clear();
+    probabilities.clear();
+    swung.clear();
+}
+
+void TriggerBuffer::addStep(
+    const int tick,
+    const size_t stepIndex,
+    const StepData& data,
+    const int velocityOffset,
+    const bool isSwung)
 {
     // Remove any existing entry for this step
-    if (const auto existing = this->stepToTick.find(stepIndex); existing != this->stepToTick.end())
-    {
-        tickToStep.erase(existing->second);
-        stepToTick.erase(existing);
-    }
+    removeStep(stepIndex);
+
+    // After any triggers already on this tick, so steps sharing a tick keep their order
+    const auto position = std::upper_bound(ticks.begin(), ticks.end(), tick) - ticks.begin();
 
-    // Add new mappings
-    tickToStep[tick] = stepIndex;
-    stepToTick[stepIndex] = tick;
+    ticks.insert(ticks.begin() + position, tick);
+    steps.insert(steps.begin() + position, static_cast<uint16_t>(stepIndex));
+    notes.insert(notes.begin() + position, data.note);
+    velocities.insert(velocities.begin() + position, data.velocity);
+    velocityOffsets.insert(velocityOffsets.begin() + position, static_cast<int8_t>(velocityOffset));
+    lengths.insert(lengths.begin() + position, static_cast<int32_t>(data.noteLength));
+    probabilities.insert(probabilities.begin() + position, data.probability);
+    swung.insert(swung.begin() + position, isSwung ? 1 : 0);
+}
+
+void TriggerBuffer::append(
+    const int tick,
+    const size_t stepIndex,
+    const StepData& data,
+    const int velocityOffset,
+    const bool isSwung)
+{
+    jassert(ticks.empty() || ticks.back() <= tick);
+
+    ticks.push_back(tick);
+    steps.push_back(static_cast<uint16_t>(stepIndex));
+    notes.push_back(data.note);
+    velocities.push_back(data.velocity);
+    velocityOffsets.push_back(static_cast<int8_t>(velocityOffset));
+    lengths.push_back(static_cast<int32_t>(data.noteLength));
+    probabilities.push_back(data.probability);
+    swung.push_back(isSwung ? 1 : 0);
 }
 
 void TriggerBuffer::removeStep(const size_t stepIndex)
 {
-    auto it = stepToTick.find(stepIndex);
-    if (it != stepToTick.end())
-    {
-        tickToStep.erase(it->second);
-        stepToTick.erase(it);
-    }
+    const auto it = std::find(steps.begin(), steps.end(), static_cast<uint16_t>(stepIndex));
+    if (it != steps.end())
+        eraseAt(static_cast<size_t>(it - steps.begin()));
 }
 
-bool TriggerBuffer::verifyIntegrity() const
+void TriggerBuffer::eraseAt(const size_t index)
 {
-    if (tickToStep.size() != stepToTick.size())
-        return false;
+    const auto position = static_cast<std::ptrdiff_t>(index);
+    ticks.erase(ticks.begin() + position);
+    steps.erase(steps.begin() + position);
+    notes.erase(notes.begin() + position);
+    velocities.erase(velocities.begin() + position);
+    velocityOffsets.erase(velocityOffsets.begin() + position);
+    lengths.erase(lengths.begin() + position);
+    probabilities.erase(probabilities.begin() + position);
+    swung.erase(swung.begin() + position);
+}
 
-    if (!std::ranges::all_of(tickToStep, [this](const auto& pair) {
-            const auto& [tick, step] = pair;
-            auto it = stepToTick.find(step);
-            return it != stepToTick.end() && it->second == tick;
-        }))
+bool TriggerBuffer::verifyIntegrity() const
+{
+    const size_t count = ticks.size();
+    if (steps.size() != count || notes.size() != count || velocities.size() != count ||
+        velocityOffsets.size() != count || lengths.size() != count || probabilities.size() != count ||
+        swung.size() != count)
     {
         return false;
     }
-    return true;
+
+    return std::is_sorted(ticks.begin(), ticks.end());
 }
 
 } // namespace Sirkus::Core
@@ -1,38 +1,53 @@
 # pragma once
 
 #include "../Constants.h"
-#include "../Identifiers.h"
 #include "../JuceHeader.h"
 #include "Step.h"
 #include "Types.h"
-#include "ValueTreeObject.h"
 
-#include "../JuceHeader.h"
-#include <atomic>
-#include <map>
-#include <mutex>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace Sirkus::Core {
 
+/*
+A pattern's triggers compiled for the engine: the enabled steps inside the pattern,
+sorted by tick, as parallel arrays with one entry per trigger. Everything the engine
+needs about a step is copied in here, so the audio thread never reads the ValueTree.
+
+Built on the message thread and never changed once the pattern has published it. An
+edit compiles a new buffer, and the TrackList's TriggerTable copies it for the engine.
+*/
 struct TriggerBuffer
 {
-    std::map<int, size_t> tickToStep; // Maps tick positions to step indices
-    std::map<size_t, int> stepToTick; // Maps step indices to tick positions
-    std::atomic<bool> dirty{false};
+    std::vector<int32_t> ticks;         // Ascending, within the pattern cycle
+    std::vector<uint16_t> steps;        // Step index
+    std::vector<uint8_t> notes;
+    std::vector<uint8_t> velocities;
+    std::vector<int8_t> velocityOffsets; // Added by the groove
+    std::vector<int32_t> lengths;       // Note length in ticks
+    std::vector<float> probabilities;
+    std::vector<uint8_t> swung;         // 1 if the tick includes the swing offset
+
+    int cycleTicks{0};                  // Pattern length times step interval
+    int stepTicks{0};                   // The step interval
+    int swingTicks{0};                  // The swing offset the ticks were compiled with
+
+    [[nodiscard]] size_t size() const { return ticks.size(); }
+    void clear();
+
+    // Insert in tick order, replacing any trigger the step already had
+    void addStep(int tick, size_t stepIndex, const StepData& data, int velocityOffset = 0, bool isSwung = false);
+
+    // Add a trigger at or after the last one, for a rebuild that has sorted its steps by tick
+    void append(int tick, size_t stepIndex, const StepData& data, int velocityOffset = 0, bool isSwung = false);
 
-    void addStep(int tick, size_t stepIndex);
     void removeStep(size_t stepIndex);
     bool verifyIntegrity() const;
 
-    // Allow copying of maps but reset dirty flag
-    TriggerBuffer& operator=(const TriggerBuffer& other)
-    {
-        tickToStep = other.tickToStep;
-        stepToTick = other.stepToTick;
-        dirty.store(false);
-        return *this;
-    }
+private:
+    void eraseAt(size_t index);
 };
 
 } // namespace Sirkus::Core
@@ -0,0 +1,116 @@
+#include "TriggerTable.h"
+
+#include "../JuceHeader.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+void TriggerTable::reserve(const size_t numSlots, const size_t numTriggers)
+{
+    ranges.reserve(numSlots);
+    ticks.reserve(numTriggers);
+    notes.reserve(numTriggers);
+    velocities.reserve(numTriggers);
+    velocityOffsets.reserve(numTriggers);
+    lengths.reserve(numTriggers);
+    probabilities.reserve(numTriggers);
+    swung.reserve(numTriggers);
+}
+
+void TriggerTable::addTrack(const TriggerBuffer& triggers)
+{
+    jassert(triggers.verifyIntegrity());
+
+    Range range;
+    range.begin = static_cast<uint32_t>(ticks.size());
+    range.end = static_cast<uint32_t>(ticks.size() + triggers.size());
+    range.cycleTicks = triggers.cycleTicks;
+    range.stepTicks = triggers.stepTicks;
+    range.swingTicks = triggers.swingTicks;
+    ranges.push_back(range);
+
+    ticks.insert(ticks.end(), triggers.ticks.begin(), triggers.ticks.end());
+    notes.insert(notes.end(), triggers.notes.begin(), triggers.notes.end());
+    velocities.insert(velocities.end(), triggers.velocities.begin(), triggers.velocities.end());
+    velocityOffsets.insert(velocityOffsets.end(), triggers.velocityOffsets.begin(), triggers.velocityOffsets.end());
+    lengths.insert(lengths.end(), triggers.lengths.begin(), triggers.lengths.end());
+    probabilities.insert(probabilities.end(), triggers.probabilities.begin(), triggers.probabilities.end());
+    swung.insert(swung.end(), triggers.swung.begin(), triggers.swung.end());
+}
+
+void TriggerTable::addLinkedTrack(const size_t earlierSlot)
+{
+    jassert(earlierSlot < ranges.size());
+    ranges.push_back(ranges[earlierSlot]);
+}
+
+size_t TriggerTable::lowerBound(const size_t begin, const size_t end, const int tick) const
+{
+    if (begin >= end)
+        return begin;
+
+    // Halve the range without a branch on the comparison, which is as good as random on
+    // the audio thread. The compiler turns the select into a conditional move
+    const int32_t* base = ticks.data() + begin;
+    size_t count = end - begin;
+    while (count > 1)
+    {
+        const size_t half = count / 2;
+        base = base[half] < tick ? base + half : base;
+        count -= half;
+    }
+
+    return static_cast<size_t>(base - ticks.data()) + (*base < tick ? 1 : 0);
+}
+
+bool TriggerTable::collect(
+    const size_t slot,
+    const int startTick,
+    const int numTicks,
+    std::vector<ActiveStep>& out) const
+{
+    out.clear();
+
+    const auto& range = ranges[slot];
+    if (range.isEmpty() || range.cycleTicks <= 0 || numTicks <= 0)
+        return true;
+
+    const int endTick = startTick + numTicks;
+
+    // Start of the pattern cycle containing startTick (floor division so negative ticks work)
+    int cycleStart = (startTick / range.cycleTicks) * range.cycleTicks;
+    if (cycleStart > startTick)
+        cycleStart -= range.cycleTicks;
+
+    // A window can straddle the end of the pattern, so visit every cycle it touches
+    for (; cycleStart < endTick; cycleStart += range.cycleTicks)
+    {
+        const int localStart = std::max(startTick - cycleStart, 0);
+        const int localEnd = std::min(endTick - cycleStart, range.cycleTicks);
+
+        const size_t first = lowerBound(range.begin, range.end, localStart);
+        const size_t wanted = lowerBound(first, range.end, localEnd);
+        const size_t last = std::min(wanted, first + (out.capacity() - out.size()));
+        for (size_t i = first; i < last; ++i)
+        {
+            const int tick = cycleStart + ticks[i];
+            out.push_back(ActiveStep{
+                tick,
+                notes[i],
+                velocities[i],
+                velocityOffsets[i],
+                lengths[i],
+                probabilities[i],
+                swung[i] != 0,
+                tick});
+        }
+
+        if (last != wanted)
+            return false;
+    }
+
+    return true;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "TriggerBuffer.h"
+#include "Types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Sirkus::Core {
+
+/*
+Every track's compiled triggers in one set of contiguous arrays, built on the message
+thread along with each TrackList and never changed after. The engine reads only this
+table, so a pattern can recompile while a block is playing the old triggers. The old
+table is freed with its list, once the engine has acknowledged a newer one.
+
+Each track slot is a range of the arrays, sorted by tick within its pattern cycle, with
+the cycle length alongside. Linked tracks share one range, their pattern is compiled
+and stored once.
+
+The engine walks the table once per block, a slot at a time in table order. The triggers
+in each pattern cycle a window touches are found with two branch-free binary searches,
+so a lookup costs log n in the track's triggers and copying out costs the triggers found.
+*/
+class TriggerTable
+{
+public:
+    struct Range
+    {
+        uint32_t begin{0};
+        uint32_t end{0};
+        int cycleTicks{0};
+        int stepTicks{0};
+        int swingTicks{0}; // The swing offset the ticks were compiled with
+
+        [[nodiscard]] bool isEmpty() const { return begin == end; }
+    };
+
+    // Message thread, while building. Slots are added in order
+    void reserve(size_t numSlots, size_t numTriggers);
+    void addTrack(const TriggerBuffer& triggers);
+    void addLinkedTrack(size_t earlierSlot); // Play an earlier slot's range again
+
+    [[nodiscard]] size_t getNumTracks() const { return ranges.size(); }
+    [[nodiscard]] size_t size() const { return ticks.size(); }
+    [[nodiscard]] const Range& getTrack(const size_t slot) const { return ranges[slot]; }
+
+    // Clear out, then add the slot's triggers in [startTick, startTick + numTicks), at their
+    // absolute ticks. out never grows past its capacity, so the audio thread can't allocate.
+    // Returns false if it filled up before every trigger was added
+    bool collect(size_t slot, int startTick, int numTicks, std::vector<ActiveStep>& out) const;
+
+    // The index of the first trigger in [begin, end) at or after tick
+    [[nodiscard]] size_t lowerBound(size_t begin, size_t end, int tick) const;
+
+private:
+    std::vector<Range> ranges;
+
+    // One entry per trigger, parallel
+    std::vector<int32_t> ticks;
+    std::vector<uint8_t> notes;
+    std::vector<uint8_t> velocities;
+    std::vector<int8_t> velocityOffsets;
+    std::vector<int32_t> lengths;
+    std::vector<float> probabilities;
+    std::vector<uint8_t> swung;
+};
+
+} // namespace Sirkus::Core
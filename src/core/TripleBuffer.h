@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Sirkus::Core {
+
+/*
+Lock-free hand-over of a value from one writer thread to one reader thread.
+
+The writer fills its private buffer and publishes it by swapping it with the shared
+middle slot. The reader picks up the middle slot only when something new has been
+published. Neither side ever waits for the other, and the reader always sees a
+complete value, never one that is half written.
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    explicit TripleBuffer(const T& initial)
+    {
+        buffers.fill(initial);
+    }
+
+    // Writer thread
+    T& getWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    void publish()
+    {
+        const auto previous = middle.exchange(static_cast<uint8_t>(writeIndex | DIRTY), std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    void write(const T& value)
+    {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    // Reader thread, whether read() would pick up a newly published value
+    [[nodiscard]] bool hasNewValue() const
+    {
+        return (middle.load(std::memory_order_relaxed) & DIRTY) != 0;
+    }
+
+    // Reader thread, returns the most recently published value. The value returned by the
+    // previous call goes back to the writer, so it mustn't be used after this
+    const T& read()
+    {
+        if ((middle.load(std::memory_order_relaxed) & DIRTY) != 0)
+        {
+            const auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & INDEX_MASK;
+        }
+
+        return buffers[readIndex];
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY = 0x4;
+
+    std::array<T, 3> buffers{};
+    uint8_t writeIndex{0};
+    std::atomic<uint8_t> middle{1};
+    uint8_t readIndex{2};
+};
+
+} // namespace Sirkus::Core
@@ -8,6 +8,8 @@ namespace Sirkus::Core {
 
 using namespace Sirkus::Constants;
 
+class Step;
+
 // Scale quantization modes
 enum class ScaleMode {
     Off,
@@ -16,13 +18,52 @@ enum class ScaleMode {
     QuantizeRandom
 };
 
+// Arpeggiator note orders, Off bypasses the arpeggiator
+enum class ArpMode {
+    Off,
+    Up,
+    Down,
+    UpDown,
+    Random,
+    AsPlayed
+};
+
+// Where a track's arpeggiator takes its notes from
+enum class ArpSource {
+    Steps,    // Notes produced by the track's own steps (overlapping steps form a chord)
+    MidiInput // Notes held on the incoming MIDI channel matching the track
+};
+
+// When a mute or solo change takes effect
+enum class MuteQuantize {
+    Immediate, // At the start of the next block
+    NextStep,  // On the track's next step
+    NextBeat,
+    NextBar
+};
+
 // Track information needed for step processing
 struct TrackInfo {
   uint32_t id;
   uint8_t midiChannel;
   ScaleMode scaleMode;
+  int8_t transpose{0};
+  float probabilityScale{1.0f};
 } __attribute__((aligned(16)));
 
+// A step triggered inside a tick window, at its absolute tick, with the compiled step data
+// needed to play it, the velocity its groove adds and whether its tick includes the swing offset
+struct ActiveStep {
+  int tick;
+  uint8_t note{60};
+  uint8_t velocity{100};
+  int velocityOffset{0};
+  int length{0}; // Ticks
+  float probability{1.0f};
+  bool swung{false};
+  int triggerTick{0}; // Where the trigger is written, before humanize or swing move it
+};
+
 enum TimeDivision {
     HundredTwentyEighthNote = STEP_128TH,
     DottedHundredTwentyEighthNote = STEP_DOTTED_128TH,
@@ -0,0 +1,133 @@
+#include "UndoHistory.h"
+
+#include <algorithm>
+
+namespace Sirkus::Core {
+
+void PropertyEditAction::apply(
+    juce::ValueTree& node,
+    const juce::Identifier& property,
+    juce::var newValue,
+    juce::UndoManager& undoManager)
+{
+    const bool exists = node.hasProperty(property);
+    if (exists && node.getProperty(property) == newValue)
+        return;
+
+    juce::var before = exists ? node.getProperty(property) : juce::var();
+    undoManager.perform(new PropertyEditAction({Edit{node, property, std::move(before), std::move(newValue)}}));
+}
+
+PropertyEditAction::PropertyEditAction(std::vector<Edit> editsToKeep)
+    : edits(std::move(editsToKeep))
+{
+    updateSize();
+}
+
+bool PropertyEditAction::perform()
+{
+    for (auto& edit : edits)
+        edit.node.setProperty(edit.property, edit.after, nullptr);
+    return true;
+}
+
+bool PropertyEditAction::undo()
+{
+    for (auto it = edits.rbegin(); it != edits.rend(); ++it)
+    {
+        if (it->before.isVoid())
+            it->node.removeProperty(it->property, nullptr);
+        else
+            it->node.setProperty(it->property, it->before, nullptr);
+    }
+    return true;
+}
+
+juce::UndoableAction* PropertyEditAction::createCoalescedAction(juce::UndoableAction* nextAction)
+{
+    const auto* next = dynamic_cast<PropertyEditAction*>(nextAction);
+    if (next == nullptr)
+        return nullptr;
+
+    // This record is deleted straight after, so its edits move rather than copy
+    auto* merged = new PropertyEditAction(std::move(edits));
+    for (const auto& edit : next->edits)
+        merged->add(edit);
+    merged->updateSize();
+    return merged;
+}
+
+void PropertyEditAction::add(const Edit& edit)
+{
+    const size_t searchFrom = edits.size() > COALESCE_WINDOW ? edits.size() - COALESCE_WINDOW : 0;
+    for (size_t i = edits.size(); i-- > searchFrom;)
+    {
+        if (edits[i].node == edit.node && edits[i].property == edit.property)
+        {
+            edits[i].after = edit.after;
+            return;
+        }
+    }
+
+    edits.push_back(edit);
+}
+
+void PropertyEditAction::updateSize()
+{
+    sizeInBytes = static_cast<int>(sizeof(*this) + edits.capacity() * sizeof(Edit));
+}
+
+UndoHistory::UndoHistory(const int budgetBytes)
+    : juce::UndoManager(std::max(budgetBytes, 1), MIN_TRANSACTIONS)
+{
+}
+
+void UndoHistory::beginGesture(const juce::String& name)
+{
+    if (gestureDepth++ == 0)
+    {
+        gestureName = name;
+        startTransaction(name);
+    }
+}
+
+void UndoHistory::endGesture()
+{
+    jassert(gestureDepth > 0);
+    if (gestureDepth > 0 && --gestureDepth == 0)
+        startTransaction({});
+}
+
+void UndoHistory::beginEdit(const juce::String& name)
+{
+    if (!isInGesture())
+        startTransaction(name);
+}
+
+void UndoHistory::beginBackgroundEdit(const juce::String& name, const bool startNew)
+{
+    // Undo and redo start a transaction too, which the name no longer matches
+    const bool stillCurrent = !startNew && transactionCount > 0 && backgroundTransaction == transactionCount
+        && getCurrentTransactionName() == name;
+
+    if (!stillCurrent)
+    {
+        startTransaction(name);
+        backgroundTransaction = transactionCount;
+    }
+}
+
+void UndoHistory::endBackgroundEdit()
+{
+    // The rest of the gesture mustn't land in the background transaction
+    if (isInGesture())
+        startTransaction(gestureName);
+}
+
+void UndoHistory::startTransaction(const juce::String& name)
+{
+    beginNewTransaction(name);
+    ++transactionCount;
+}
+
+} // namespace Sirkus::Core
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../JuceHeader.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Sirkus::Core {
+
+/*
+The undo record for property edits: a flat list of (node, property, before, after).
+
+ValueTreeObject writes every property through this instead of letting the ValueTree
+create one action per change. Within a transaction, each new edit is folded into the
+previous record. An edit to a node and property that is already in the record only
+moves its "after" value, so dragging a slider across a step leaves one entry. A bulk
+edit of every step leaves one record with one entry per step, in a single allocation.
+
+The size reported to the UndoManager is the record's size in bytes, so the history's
+limit is a memory budget.
+*/
+class PropertyEditAction final : public juce::UndoableAction
+{
+public:
+    // Set the property, recording the change in the undo manager's current transaction
+    static void apply(
+        juce::ValueTree& node,
+        const juce::Identifier& property,
+        juce::var newValue,
+        juce::UndoManager& undoManager);
+
+    bool perform() override;
+    bool undo() override;
+    int getSizeInUnits() override { return sizeInBytes; }
+    juce::UndoableAction* createCoalescedAction(juce::UndoableAction* nextAction) override;
+
+private:
+    struct Edit
+    {
+        juce::ValueTree node;
+        juce::Identifier property;
+        juce::var before; // Void if the property didn't exist
+        juce::var after;
+    };
+
+    // How far back a new edit looks for one on the same node and property
+    static constexpr size_t COALESCE_WINDOW = 256;
+
+    explicit PropertyEditAction(std::vector<Edit> editsToKeep);
+    void add(const Edit& edit);
+    void updateSize();
+
+    std::vector<Edit> edits;
+    int sizeInBytes{0}; // Kept as reported, the UndoManager subtracts it after coalescing
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PropertyEditAction)
+};
+
+/*
+The plugin's undo history. Memory is limited by a byte budget rather than a count of
+transactions, and the UI groups its edits into transactions:
+
+- a gesture, such as a slider drag, is one transaction from beginGesture() to endGesture()
+- any other edit starts its own transaction with beginEdit()
+- edits the plugin makes by itself, such as recording, go between beginBackgroundEdit() and
+  endBackgroundEdit(). They never share a transaction with the UI's edits, even mid-gesture
+
+Message thread only.
+*/
+class UndoHistory final : public juce::UndoManager
+{
+public:
+    static constexpr int DEFAULT_BUDGET_BYTES = 4 * 1024 * 1024;
+    static constexpr int MIN_TRANSACTIONS = 8; // Kept even if they are over the budget
+
+    explicit UndoHistory(int budgetBytes = DEFAULT_BUDGET_BYTES);
+
+    void beginGesture(const juce::String& name);
+    void endGesture();
+    [[nodiscard]] bool isInGesture() const { return gestureDepth > 0; }
+
+    // A new transaction for a one-off edit, or nothing if the edit is part of a gesture
+    void beginEdit(const juce::String& name);
+
+    // Background edits carry on in one transaction until anything else starts another, or
+    // startNew is set. A gesture they interrupted continues in a new transaction afterwards
+    void beginBackgroundEdit(const juce::String& name, bool startNew = false);
+    void endBackgroundEdit();
+
+private:
+    void startTransaction(const juce::String& name);
+
+    int gestureDepth{0};
+    juce::String gestureName;
+
+    // Counts the transactions started here, to tell whether the background one is still current
+    uint64_t transactionCount{0};
+    uint64_t backgroundTransaction{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UndoHistory)
+};
+
+} // namespace Sirkus::Core
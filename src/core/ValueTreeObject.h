@@ -2,6 +2,7 @@
 
 
 #include "../JuceHeader.h"
+#include "UndoHistory.h"
 
 namespace Sirkus::Core {
 
@@ -10,8 +11,8 @@ using namespace juce;
 /*
 
 ValueTreeObject is a base class for objects that are stored in a ValueTree. It provides
-convenience methods for setting and getting properties in the ValueTree, and automatically
-adds itself as a listener to the ValueTree.
+convenience methods for setting and getting properties in the ValueTree. It doesn't listen
+to its own state: the sequencer's ChangeDispatcher is the one listener on the whole tree.
 
 Example usage of TypedProperty and ValueTreeObject
 
@@ -29,40 +30,68 @@ public:
     MyObject(ValueTree parentState, UndoManager& undoManager)
         : ValueTreeObject(parentState, IDs::myObject, undoManager)
     {
-        // Set default values
-        setProperty(TypedProperty<bool>{ IDs::foo }, false);
-        setProperty(TypedProperty<int>{ IDs::midiChannel }, 1);
-        setProperty(TypedProperty<float>{ IDs::bpm }, 120.0f);
     }
 
+    // One static table for the class, indices in declaration order
+    struct Schema
+    {
+        static constexpr TypedProperty<bool> foo{IDs::foo, false, 0};
+        static constexpr TypedProperty<int> midiChannel{IDs::midiChannel, 1, 1};
+        static constexpr TypedProperty<float> bpm{IDs::bpm, 120.0f, 2};
+        static constexpr size_t NUM_PROPERTIES = 3;
+    };
+
+    static constexpr Schema props{};
+
     // Accessors
-    bool getFoo() const { return getProperty(TypedProperty<bool>{ IDs::foo }); }
-    void setFoo(bool value) { setProperty(TypedProperty<bool>{ IDs::foo }, value); }
+    bool getFoo() const { return getProperty(props.foo); }
+    void setFoo(bool value) { setProperty(props.foo, value); }
 
-    int getMidiChannel() const { return getProperty(TypedProperty<int>{ IDs::midiChannel }); }
-    void setMidiChannel(int value) { setProperty(TypedProperty<int>{ IDs::midiChannel }, value); }
+    int getMidiChannel() const { return getProperty(props.midiChannel); }
+    void setMidiChannel(int value) { setProperty(props.midiChannel, value); }
 
-    float getBpm() const { return getProperty(TypedProperty<float>{ IDs::bpm }); }
-    void setBpm(float value) { setProperty(TypedProperty<float>{ IDs::bpm }, value); }
+    float getBpm() const { return getProperty(props.bpm); }
+    void setBpm(float value) { setProperty(props.bpm, value); }
 };
 
 */
 
+/*
+One entry in a class's property schema: the identifier, the type, the default and the
+property's position in the schema.
+
+Schemas are static, so every object of a class shares one table rather than carrying its
+own copies of the identifiers. The identifier is held by reference to the one in
+Identifiers.h, and for literal types the whole entry is constexpr.
+*/
 template <typename T>
 struct TypedProperty
 {
-    const juce::Identifier id;
+    using Type = T;
+
+    const juce::Identifier& id;
     const T defaultValue;
+    const size_t index;
 
-    TypedProperty(const juce::Identifier& identifier, T defaultVal)
+    constexpr TypedProperty(const juce::Identifier& identifier, T defaultVal, size_t indexInSchema = 0)
         : id(identifier)
           , defaultValue(defaultVal)
+          , index(indexInSchema)
     {
     }
 };
 
 
-class ValueTreeObject : public ValueTree::Listener
+// The schema index of the property with this identifier, or -1 if none of them has it
+template <typename... Properties>
+int findPropertyIndex(const juce::Identifier& id, const Properties&... properties)
+{
+    int index = -1;
+    ((properties.id == id ? (index = static_cast<int>(properties.index), true) : false) || ...);
+    return index;
+}
+
+class ValueTreeObject
 {
 protected:
     ValueTreeObject(ValueTree parentState, const Identifier& type, UndoManager& undoManagerToUse, int index = -1)
@@ -70,7 +99,6 @@ protected:
           , undoManager(undoManagerToUse)
     {
         parentState.addChild(state, index, &undoManager);
-        state.addListener(this);
         DBG("State is valid: " << std::to_string(state.isValid()));
     }
 
@@ -79,60 +107,32 @@ protected:
         : state(existingState)
           , undoManager(undoManagerToUse)
     {
-        // TODO: is this a duplicate listener? Does it matter?
-        state.addListener(this);
     }
 
     // Copy constructor
-    ValueTreeObject(const ValueTreeObject& other)
-        : state(other.state)
-          , undoManager(other.undoManager)
-    {
-        state.addListener(this);
-    }
+    ValueTreeObject(const ValueTreeObject& other) = default;
 
     // Copy assignment operator
     ValueTreeObject& operator=(const ValueTreeObject& other)
     {
         if (this != &other)
-        {
-            state.removeListener(this);
             state = other.state;
-            state.addListener(this);
-        }
         return *this;
     }
 
-    ~ValueTreeObject() override
-    {
-        state.removeListener(this);
-    }
-
-    void valueTreePropertyChanged(
-        ValueTree& treeWhosePropertyHasChanged,
-        const Identifier& property) override
-    {
-        DBG("ValueTreeObject::valueTreePropertyChanged: " << property.toString());
-    }
-
-    void valueTreeChildAdded(
-        ValueTree& parentTree,
-        ValueTree& childWhichHasBeenAdded) override
-    {
-        DBG("ValueTreeObject::valueTreeChildAdded: " << childWhichHasBeenAdded.getType().toString());
-    }
+    virtual ~ValueTreeObject() = default;
 
 public:
     template <typename T>
     void setProperty(const Identifier& id, T value)
     {
-        state.setProperty(id, VariantConverter<T>::toVar(value), &undoManager);
+        PropertyEditAction::apply(state, id, VariantConverter<T>::toVar(value), undoManager);
     }
 
     template <typename T>
     void setProperty(const TypedProperty<T>& property, T value)
     {
-        state.setProperty(property.id, VariantConverter<T>::toVar(value), &undoManager);
+        PropertyEditAction::apply(state, property.id, VariantConverter<T>::toVar(value), undoManager);
     }
 
     template <typename T>
@@ -158,7 +158,7 @@ protected:
     void initProperty(const TypedProperty<T>& property)
     {
         if (!state.hasProperty(property.id))
-            setProperty(property, VariantConverter<T>::toVar(property.defaultValue));
+            setProperty(property, property.defaultValue);
     }
 
     ValueTree state;
@@ -92,6 +92,12 @@ DECLARE_ENUM_VARIANT_CONVERTER(Sirkus::Core::TimeDivision)
 
 DECLARE_ENUM_VARIANT_CONVERTER(Sirkus::Core::ScaleMode)
 
+DECLARE_ENUM_VARIANT_CONVERTER(Sirkus::Core::ArpMode)
+
+DECLARE_ENUM_VARIANT_CONVERTER(Sirkus::Core::ArpSource)
+
+DECLARE_ENUM_VARIANT_CONVERTER(Sirkus::Core::MuteQuantize)
+
 #endif // JUCE_MODULE_AVAILABLE_juce_core
 
 } // namespace juce
@@ -24,7 +24,7 @@ public:
 
     static constexpr int VISIBLE_STEPS = 16;
     static constexpr int MIN_PATTERN_LENGTH = 1;
-    static constexpr int MAX_PATTERN_LENGTH = 128;
+    static constexpr int MAX_PATTERN_LENGTH = Sirkus::Constants::MAX_STEPS;
 
     //explicit PatternTrack(int trackNumber);
     explicit PatternTrack(Sirkus::Core::Track& track);
@@ -25,6 +25,7 @@ void StepControls::setupNoteControls()
     noteSlider->onValueChange = [this] {
         setNoteValue(static_cast<int>(noteSlider->getValue()));
     };
+    attachGesture(*noteSlider);
     addAndMakeVisible(noteSlider.get());
 }
 
@@ -42,6 +43,7 @@ void StepControls::setupVelocityControls()
     velocitySlider->onValueChange = [this] {
         setVelocity(static_cast<int>(velocitySlider->getValue()));
     };
+    attachGesture(*velocitySlider);
     addAndMakeVisible(velocitySlider.get());
 }
 
@@ -63,6 +65,22 @@ void StepControls::setupNoteLengthControls()
     addAndMakeVisible(noteLengthCombo.get());
 }
 
+void StepControls::attachGesture(juce::Slider& slider)
+{
+    slider.onDragStart = [this] {
+        listeners.call(
+            [this](Listener& l) {
+                l.editGestureStarted(this);
+            });
+    };
+    slider.onDragEnd = [this] {
+        listeners.call(
+            [this](Listener& l) {
+                l.editGestureEnded(this);
+            });
+    };
+}
+
 void StepControls::updateNoteLengthComboBox()
 {
     noteLengthCombo->clear(juce::dontSendNotification);
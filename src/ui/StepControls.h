@@ -58,6 +58,10 @@ public:
         virtual void noteValueChanged(StepControls* controls, int newValue) = 0;
         virtual void velocityChanged(StepControls* controls, int newValue) = 0;
         virtual void noteLengthChanged(Sirkus::UI::StepControls* controls, Sirkus::Core::TimeDivision newLength) = 0;
+
+        /** A slider drag started or ended, the changes in between belong together */
+        virtual void editGestureStarted(StepControls* controls) { juce::ignoreUnused(controls); }
+        virtual void editGestureEnded(StepControls* controls) { juce::ignoreUnused(controls); }
     };
 
     void addListener(Listener* listener);
@@ -87,6 +91,7 @@ private:
     void setupVelocityControls();
     void setupNoteLengthControls();
     void updateNoteLengthComboBox();
+    void attachGesture(juce::Slider& slider);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StepControls)
 };
@@ -0,0 +1,175 @@
+#include "core/ClockTempoEstimator.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using Sirkus::Core::ClockTempoEstimator;
+
+namespace {
+
+constexpr double SAMPLE_RATE = 48000.0;
+constexpr int PULSES_PER_QUARTER_NOTE = 24;
+
+double periodForBpm(const double bpm)
+{
+    return 60.0 * SAMPLE_RATE / (bpm * PULSES_PER_QUARTER_NOTE);
+}
+
+// Deterministic jitter in [-amount, amount], so failures reproduce
+double jitter(const int pulse, const double amount)
+{
+    return amount * std::sin(static_cast<double>(pulse) * 12.9898) * std::cos(static_cast<double>(pulse) * 4.1414);
+}
+
+} // namespace
+
+TEST_CASE("ClockTempoEstimator needs two pulses for an estimate", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+
+    CHECK_FALSE(estimator.hasEstimate());
+    CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == 0.0);
+
+    estimator.addPulse(0.0);
+    CHECK_FALSE(estimator.hasEstimate());
+
+    estimator.addPulse(periodForBpm(120.0));
+    REQUIRE(estimator.hasEstimate());
+    CHECK_FALSE(estimator.isLocked());
+    CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(120.0));
+    CHECK(estimator.getBpm(0) == 0.0);
+}
+
+TEST_CASE("ClockTempoEstimator follows a steady clock exactly", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+
+    const double period = periodForBpm(128.0);
+    for (int pulse = 0; pulse < ClockTempoEstimator::PULSES_TO_LOCK; ++pulse)
+        estimator.addPulse(pulse * period);
+
+    REQUIRE(estimator.isLocked());
+    CHECK(estimator.getPeriod() == Catch::Approx(period));
+    CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(128.0));
+    CHECK(estimator.getLastPulseTime() == Catch::Approx((ClockTempoEstimator::PULSES_TO_LOCK - 1) * period));
+    CHECK(estimator.getNextPulseTime() == Catch::Approx(ClockTempoEstimator::PULSES_TO_LOCK * period));
+}
+
+TEST_CASE("ClockTempoEstimator smooths jitter", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+
+    // A quarter of a millisecond either way, typical of a USB interface
+    const double period = periodForBpm(120.0);
+    const double amount = 0.00025 * SAMPLE_RATE;
+
+    // The first period is measured from two jittered pulses, so the loop starts off and
+    // has to settle. It should be within 0.05% within two beats and stay there
+    constexpr int settledBy = 24 * 2;
+    int lastUnsettledPulse = -1;
+
+    double worstRawError = 0.0;
+    double worstFilteredError = 0.0;
+    for (int pulse = 0; pulse < 24 * 32; ++pulse)
+    {
+        const double ideal = pulse * period;
+        const double received = ideal + jitter(pulse, amount);
+        estimator.addPulse(received);
+
+        if (std::abs(estimator.getBpm(PULSES_PER_QUARTER_NOTE) - 120.0) > 120.0 * 0.0005)
+            lastUnsettledPulse = pulse;
+
+        if (pulse >= settledBy)
+        {
+            worstRawError = std::max(worstRawError, std::abs(received - ideal));
+            worstFilteredError = std::max(worstFilteredError, std::abs(estimator.getLastPulseTime() - ideal));
+        }
+    }
+
+    CHECK(lastUnsettledPulse < settledBy);
+    CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(120.0).epsilon(0.0005));
+    CHECK(worstFilteredError < worstRawError);
+}
+
+TEST_CASE("ClockTempoEstimator follows a tempo change", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+
+    double time = 0.0;
+    for (int pulse = 0; pulse < 24 * 8; ++pulse, time += periodForBpm(100.0))
+        estimator.addPulse(time);
+
+    REQUIRE(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(100.0));
+
+    // The loop's damping lets it overshoot by a few percent of the step, and it is within
+    // 0.1% of the new tempo within two beats
+    constexpr int settledBy = 24 * 2;
+    int lastUnsettledPulse = -1;
+    double peakBpm = 0.0;
+    for (int pulse = 0; pulse < 24 * 8; ++pulse, time += periodForBpm(110.0))
+    {
+        estimator.addPulse(time);
+        const double bpm = estimator.getBpm(PULSES_PER_QUARTER_NOTE);
+        peakBpm = std::max(peakBpm, bpm);
+        if (std::abs(bpm - 110.0) > 110.0 * 0.001)
+            lastUnsettledPulse = pulse;
+    }
+
+    CHECK(peakBpm < 110.0 + 0.05 * (110.0 - 100.0));
+    CHECK(lastUnsettledPulse < settledBy);
+    CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(110.0).epsilon(0.001));
+}
+
+TEST_CASE("ClockTempoEstimator restarts after a dropout", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+
+    const double period = periodForBpm(120.0);
+    for (int pulse = 0; pulse < ClockTempoEstimator::PULSES_TO_LOCK; ++pulse)
+        estimator.addPulse(pulse * period);
+
+    REQUIRE(estimator.isLocked());
+
+    SECTION("a long gap")
+    {
+        estimator.addPulse(estimator.getNextPulseTime() + 10.0 * period);
+        CHECK_FALSE(estimator.hasEstimate());
+        CHECK_FALSE(estimator.isLocked());
+    }
+
+    SECTION("a pulse more than a period early")
+    {
+        estimator.addPulse(estimator.getNextPulseTime() - 1.5 * period);
+        CHECK_FALSE(estimator.hasEstimate());
+    }
+
+    SECTION("a new clock after the gap")
+    {
+        const double restart = estimator.getNextPulseTime() + 10.0 * period;
+        const double newPeriod = periodForBpm(90.0);
+        estimator.addPulse(restart);
+        estimator.addPulse(restart + newPeriod);
+        CHECK(estimator.getBpm(PULSES_PER_QUARTER_NOTE) == Catch::Approx(90.0));
+    }
+}
+
+TEST_CASE("ClockTempoEstimator resets", "[clock]")
+{
+    ClockTempoEstimator estimator;
+    estimator.prepare(SAMPLE_RATE);
+    estimator.addPulse(0.0);
+    estimator.addPulse(periodForBpm(120.0));
+    REQUIRE(estimator.hasEstimate());
+
+    estimator.reset();
+    CHECK_FALSE(estimator.hasEstimate());
+    CHECK(estimator.getPeriod() == 0.0);
+}
@@ -0,0 +1,103 @@
+#include "Constants.h"
+#include "core/InternalTransport.h"
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <utility>
+
+using Sirkus::Core::InternalTransport;
+using Sirkus::Core::TempoMap;
+using Sirkus::Core::TempoRamp;
+
+namespace {
+
+constexpr double SAMPLE_RATE = 48000.0;
+
+// 120 BPM for four bars, then a linear ramp up to 150 over the next four
+TempoMap makeRampedMap()
+{
+    TempoMap map;
+    map.setTempo(120.0);
+    map.addTempoEvent(16 * Sirkus::Constants::PPQN, 120.0, TempoRamp::Linear);
+    map.addTempoEvent(32 * Sirkus::Constants::PPQN, 150.0);
+    return map;
+}
+
+void play(InternalTransport& transport, const int totalSamples, const int blockSize)
+{
+    for (int played = 0; played < totalSamples; played += blockSize)
+        transport.processBlock(std::min(blockSize, totalSamples - played));
+}
+
+} // namespace
+
+TEST_CASE("InternalTransport continues from the same tick when the tempo map changes", "[transport]")
+{
+    InternalTransport transport;
+    transport.prepare(SAMPLE_RATE);
+    transport.setBpm(120.0);
+    transport.start();
+
+    play(transport, 48000, 512);
+    const int64_t endTick = transport.getBlockTiming().endTick;
+    const double samplesPerTick = transport.getBlockTiming().getSamplesPerTick();
+    const double expectedPpq = transport.getTimingInfo().ppqPosition
+        + transport.getBlockTiming().numSamples / samplesPerTick / Sirkus::Constants::PPQN;
+
+    SECTION("to a ramped map")
+    {
+        transport.setTempoMap(makeRampedMap());
+        transport.processBlock(512);
+    }
+
+    SECTION("to another single tempo")
+    {
+        transport.setBpm(97.0);
+        transport.processBlock(512);
+    }
+
+    CHECK(transport.getBlockTiming().startTick == endTick);
+    CHECK(transport.getTimingInfo().ppqPosition == Catch::Approx(expectedPpq).margin(1.0e-6));
+}
+
+TEST_CASE("InternalTransport lands on the same tick whatever the block size", "[transport]")
+{
+    const auto positionAfter = [](const int blockSize) {
+        InternalTransport transport;
+        transport.prepare(SAMPLE_RATE);
+        transport.setTempoMap(makeRampedMap());
+        transport.start();
+
+        // Far enough to be inside the ramp
+        play(transport, 48000 * 12, blockSize);
+        transport.processBlock(1);
+        return std::pair{transport.getBlockTiming().startTick, transport.getTimingInfo().ppqPosition};
+    };
+
+    const auto small = positionAfter(64);
+    const auto large = positionAfter(1000);
+    const auto odd = positionAfter(333);
+
+    CHECK(small.first == large.first);
+    CHECK(small.first == odd.first);
+    CHECK(small.second == large.second);
+    CHECK(small.second == odd.second);
+}
+
+TEST_CASE("InternalTransport keeps the position across a tempo map change while stopped", "[transport]")
+{
+    InternalTransport transport;
+    transport.prepare(SAMPLE_RATE);
+    transport.setTempoMap(makeRampedMap());
+    transport.setPositionInBars(7);
+    transport.processBlock(256);
+
+    const double ppq = transport.getTimingInfo().ppqPosition;
+    REQUIRE(ppq == Catch::Approx(24.0).margin(1.0e-3));
+
+    transport.setBpm(133.0);
+    transport.processBlock(256);
+    CHECK(transport.getTimingInfo().ppqPosition == Catch::Approx(ppq).margin(1.0e-3));
+}
@@ -0,0 +1,153 @@
+#include "core/MidiBufferUtils.h"
+#include "core/MidiEventQueue.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <utility>
+#include <vector>
+
+using Sirkus::Core::MidiEventQueue;
+namespace MidiBufferUtils = Sirkus::Core::MidiBufferUtils;
+
+namespace {
+
+struct Event
+{
+    std::vector<juce::uint8> bytes;
+    int samplePosition;
+};
+
+// Out of order, with ties, a realtime message and a sysex
+std::vector<Event> makeEvents()
+{
+    return {
+        {{0x90, 60, 100}, 12},
+        {{0x80, 60, 0}, 3},
+        {{0xF8}, 12},
+        {{0x91, 64, 90}, 0},
+        {{0xF0, 0x7D, 0x01, 0x02, 0xF7}, 7},
+        {{0x81, 64, 0}, 12},
+        {{0xB0, 123, 0}, 3},
+    };
+}
+
+std::vector<juce::uint8> contents(const juce::MidiBuffer& buffer)
+{
+    std::vector<juce::uint8> bytes;
+    for (const auto metadata : buffer)
+    {
+        bytes.push_back(static_cast<juce::uint8>(metadata.samplePosition));
+        bytes.insert(bytes.end(), metadata.data, metadata.data + metadata.numBytes);
+    }
+    return bytes;
+}
+
+} // namespace
+
+TEST_CASE("MidiEventQueue writes what MidiBuffer::addEvent would", "[midi]")
+{
+    REQUIRE(MidiBufferUtils::canAppendDirectly());
+
+    MidiEventQueue queue;
+    queue.prepare(64, 256);
+
+    juce::MidiBuffer expected;
+    for (const auto& event : makeEvents())
+    {
+        queue.addEvent(event.bytes.data(), static_cast<int>(event.bytes.size()), event.samplePosition);
+        expected.addEvent(event.bytes.data(), static_cast<int>(event.bytes.size()), event.samplePosition);
+    }
+
+    juce::MidiBuffer written;
+    written.ensureSize(static_cast<size_t>(queue.getMidiBufferBytes()));
+
+    // Anything already in the buffer is replaced
+    const juce::uint8 stale[] = {0x90, 1, 1};
+    written.addEvent(stale, 3, 0);
+
+    queue.writeTo(written);
+    CHECK(contents(written) == contents(expected));
+    CHECK(written.data == expected.data);
+    CHECK(queue.isEmpty());
+}
+
+TEST_CASE("MidiBufferUtils trims and drops events as MidiBuffer::addEvent does", "[midi]")
+{
+    // A note on with a stray byte, running status and an unterminated sysex
+    const juce::uint8 longNoteOn[] = {0x90, 60, 100, 5};
+    const juce::uint8 runningStatus[] = {60, 100};
+    const juce::uint8 sysex[] = {0xF0, 0x7D, 0x01};
+
+    juce::MidiBuffer expected;
+    expected.addEvent(longNoteOn, 4, 0);
+    expected.addEvent(runningStatus, 2, 1);
+    expected.addEvent(sysex, 3, 2);
+
+    juce::MidiBuffer written;
+    MidiBufferUtils::appendInOrder(written, longNoteOn, 4, 0);
+    MidiBufferUtils::appendInOrder(written, runningStatus, 2, 1);
+    MidiBufferUtils::appendInOrder(written, sysex, 3, 2);
+
+    CHECK(written.data == expected.data);
+}
+
+TEST_CASE("MidiBufferUtils appends a whole buffer after another", "[midi]")
+{
+    const juce::uint8 noteOn[] = {0x90, 60, 100};
+    const juce::uint8 noteOff[] = {0x80, 60, 0};
+
+    juce::MidiBuffer source;
+    source.addEvent(noteOn, 3, 4);
+    source.addEvent(noteOff, 3, 9);
+
+    juce::MidiBuffer expected;
+    expected.addEvent(noteOff, 3, 4);
+    expected.addEvent(noteOn, 3, 4);
+    expected.addEvent(noteOff, 3, 9);
+
+    juce::MidiBuffer written;
+    written.addEvent(noteOff, 3, 4);
+    MidiBufferUtils::appendAll(written, source);
+
+    CHECK(written.data == expected.data);
+}
+
+TEST_CASE("MidiEventQueue merges a sorted run, losing ties to the other events", "[midi]")
+{
+    MidiEventQueue queue;
+    queue.prepare(64, 256);
+
+    const juce::uint8 generated[] = {0x90, 60, 100};
+    const juce::uint8 input[] = {0x91, 62, 80};
+
+    // Generated out of order, then the input in order as thru adds it
+    queue.addEvent(generated, 3, 8);
+    queue.addEvent(generated, 3, 2);
+    queue.beginSortedRun();
+    queue.addEvent(input, 3, 0);
+    queue.addEvent(input, 3, 2);
+    queue.addEvent(input, 3, 9);
+
+    juce::MidiBuffer written;
+    queue.writeTo(written);
+
+    std::vector<std::pair<int, juce::uint8>> order;
+    for (const auto metadata : written)
+        order.emplace_back(metadata.samplePosition, metadata.data[0]);
+
+    const std::vector<std::pair<int, juce::uint8>> expected{
+        {0, 0x91},
+        {2, 0x90},
+        {2, 0x91},
+        {8, 0x90},
+        {9, 0x91},
+    };
+    CHECK(order == expected);
+
+    // The next block starts without a run
+    queue.addEvent(generated, 3, 5);
+    queue.addEvent(generated, 3, 1);
+    queue.writeTo(written);
+    CHECK(written.getNumEvents() == 2);
+    CHECK((*written.begin()).samplePosition == 1);
+}
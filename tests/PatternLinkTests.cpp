@@ -0,0 +1,154 @@
+#include "JuceHeader.h"
+#include "core/Pattern.h"
+#include "core/Sequencer.h"
+#include "core/Step.h"
+#include "core/Track.h"
+#include "core/TrackList.h"
+#include "core/UndoHistory.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <vector>
+
+using Sirkus::Core::Pattern;
+using Sirkus::Core::Sequencer;
+using Sirkus::Core::Track;
+using Sirkus::Core::TrackListPublisher;
+using Sirkus::Core::UndoHistory;
+
+namespace {
+
+// A sequencer with two tracks, the first made by the sequencer itself
+struct TwoTracks
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ValueTree root{"root"};
+    UndoHistory undoHistory;
+    Sequencer sequencer{root, undoHistory};
+    uint32_t first{(*sequencer.getTracks().begin())->getId()};
+    uint32_t second{sequencer.createTrack()};
+
+    uint8_t noteOf(const uint32_t trackId)
+    {
+        return sequencer.getCurrentPatternForTrack(trackId).getStep(0).getNote();
+    }
+};
+
+} // namespace
+
+TEST_CASE("Linked tracks share one pattern, compiled once", "[patterns]")
+{
+    TwoTracks fixture;
+    auto& sequencer = fixture.sequencer;
+
+    REQUIRE(sequencer.linkPattern(fixture.second, fixture.first));
+    CHECK(sequencer.isPatternLinked(fixture.first));
+    CHECK(sequencer.isPatternLinked(fixture.second));
+    CHECK_FALSE(sequencer.linkPattern(fixture.second, fixture.first));
+
+    const auto& firstPattern = sequencer.getTrack(fixture.first).getSharedPattern();
+    const auto& secondPattern = sequencer.getTrack(fixture.second).getSharedPattern();
+    CHECK(firstPattern == secondPattern);
+    CHECK(firstPattern->getTriggers() == secondPattern->getTriggers());
+
+    // The shared tree lives under exactly one of the tracks
+    CHECK(
+        sequencer.getTrack(fixture.first).holdsPatternTree() != sequencer.getTrack(fixture.second).holdsPatternTree());
+
+    // An edit from either track is an edit to both
+    sequencer.getCurrentPatternForTrack(fixture.second).getStep(0).setNote(70);
+    CHECK(fixture.noteOf(fixture.first) == 70);
+}
+
+TEST_CASE("Unlinking gives a track its own copy", "[patterns]")
+{
+    TwoTracks fixture;
+    auto& sequencer = fixture.sequencer;
+
+    CHECK_FALSE(sequencer.unlinkPattern(fixture.second));
+
+    REQUIRE(sequencer.linkPattern(fixture.second, fixture.first));
+    sequencer.getCurrentPatternForTrack(fixture.first).getStep(0).setNote(64);
+
+    // Unlink whichever track holds the tree, so the hand-over is covered too
+    const uint32_t holder =
+        sequencer.getTrack(fixture.first).holdsPatternTree() ? fixture.first : fixture.second;
+    const uint32_t other = holder == fixture.first ? fixture.second : fixture.first;
+
+    REQUIRE(sequencer.unlinkPattern(holder));
+    CHECK_FALSE(sequencer.isPatternLinked(fixture.first));
+    CHECK_FALSE(sequencer.isPatternLinked(fixture.second));
+    CHECK(sequencer.getTrack(holder).holdsPatternTree());
+    CHECK(sequencer.getTrack(other).holdsPatternTree());
+
+    // The copy starts with the shared steps and is edited on its own from then on
+    CHECK(fixture.noteOf(holder) == 64);
+    sequencer.getCurrentPatternForTrack(holder).getStep(0).setNote(50);
+    CHECK(fixture.noteOf(holder) == 50);
+    CHECK(fixture.noteOf(other) == 64);
+}
+
+TEST_CASE("Removing a linked track leaves its pattern with the others", "[patterns]")
+{
+    TwoTracks fixture;
+    auto& sequencer = fixture.sequencer;
+
+    SECTION("the track holding the shared tree can't be brought back by undo")
+    {
+        REQUIRE(sequencer.linkPattern(fixture.second, fixture.first));
+        sequencer.getCurrentPatternForTrack(fixture.first).getStep(0).setNote(67);
+
+        const uint32_t holder =
+            sequencer.getTrack(fixture.first).holdsPatternTree() ? fixture.first : fixture.second;
+        const uint32_t other = holder == fixture.first ? fixture.second : fixture.first;
+
+        fixture.undoHistory.clearUndoHistory();
+        REQUIRE(sequencer.removeTrack(holder));
+
+        CHECK(sequencer.findTrack(holder) == nullptr);
+        CHECK(sequencer.getTrack(other).holdsPatternTree());
+        CHECK(fixture.noteOf(other) == 67);
+        CHECK_FALSE(sequencer.isPatternLinked(other));
+        CHECK_FALSE(fixture.undoHistory.canUndo());
+    }
+
+    SECTION("a track with its own pattern can")
+    {
+        fixture.undoHistory.clearUndoHistory();
+        REQUIRE(sequencer.removeTrack(fixture.second));
+        CHECK(fixture.undoHistory.canUndo());
+    }
+}
+
+TEST_CASE("A removed track is only freed once the engine has let go", "[patterns]")
+{
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ValueTree root{"root"};
+    UndoHistory undoHistory;
+    TrackListPublisher publisher;
+
+    auto track = std::make_unique<Track>(root, undoHistory, 1);
+    const std::weak_ptr<Pattern> pattern = track->getSharedPattern();
+
+    // The engine is still playing the list the track was in
+    publisher.publish({track.get()}, {}, 0);
+    publisher.acknowledge(publisher.getLatest()->epoch);
+
+    std::vector<std::unique_ptr<Track>> retired;
+    retired.push_back(std::move(track));
+    publisher.publish({}, {}, 0, std::move(retired));
+    const uint64_t removedEpoch = publisher.getLatest()->epoch;
+
+    publisher.reclaim();
+    CHECK_FALSE(pattern.expired());
+
+    // Acknowledging the list before doesn't free it
+    publisher.acknowledge(removedEpoch - 1);
+    publisher.reclaim();
+    CHECK_FALSE(pattern.expired());
+
+    publisher.acknowledge(removedEpoch);
+    publisher.reclaim();
+    CHECK(pattern.expired());
+}
@@ -0,0 +1,54 @@
+#include "Constants.h"
+#include "core/Pattern.h"
+#include "core/UndoHistory.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+using Sirkus::Core::Pattern;
+using Sirkus::Core::UndoHistory;
+
+TEST_CASE("A pattern only creates the pages of steps that are used", "[patterns]")
+{
+    constexpr auto pageSteps = static_cast<size_t>(Sirkus::Constants::STEPS_PER_PAGE);
+    constexpr auto lastStep = static_cast<size_t>(Sirkus::Constants::MAX_STEPS) - 1;
+
+    juce::ValueTree track{"track"};
+    UndoHistory undoHistory;
+    Pattern pattern(track, undoHistory);
+    pattern.setLength(lastStep + 1);
+
+    CHECK(pattern.findStep(0) == nullptr);
+
+    pattern.setStepNote(lastStep, 72);
+    pattern.setStepEnabled(lastStep, true);
+
+    // Only the last page, not every page before it
+    const auto patternTree = track.getChild(0);
+    CHECK(patternTree.getNumChildren() == static_cast<int>(pageSteps));
+    CHECK(pattern.findStep(0) == nullptr);
+    CHECK(pattern.findStep(lastStep - pageSteps) == nullptr);
+    CHECK(pattern.findStep(lastStep + 1 - pageSteps) != nullptr);
+    REQUIRE(pattern.findStep(lastStep) != nullptr);
+    CHECK(pattern.findStep(lastStep)->getNote() == 72);
+    CHECK(pattern.isStepEnabled(lastStep));
+    CHECK_FALSE(pattern.isStepEnabled(0));
+
+    // A page created later finds its steps by index, wherever they are in the tree
+    pattern.setStepNote(3, 40);
+    CHECK(patternTree.getNumChildren() == static_cast<int>(2 * pageSteps));
+    CHECK(pattern.getStep(3).getNote() == 40);
+    CHECK(pattern.getStep(lastStep).getNote() == 72);
+
+    SECTION("a copy has the same pages")
+    {
+        juce::ValueTree otherTrack{"track"};
+        const Pattern copy(otherTrack, undoHistory, pattern);
+
+        CHECK(copy.findStep(pageSteps) == nullptr);
+        REQUIRE(copy.findStep(3) != nullptr);
+        CHECK(copy.findStep(3)->getNote() == 40);
+        REQUIRE(copy.findStep(lastStep) != nullptr);
+        CHECK(copy.findStep(lastStep)->getNote() == 72);
+        CHECK(copy.isStepEnabled(lastStep));
+    }
+}
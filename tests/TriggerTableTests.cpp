@@ -0,0 +1,152 @@
+#include "Constants.h"
+#include "core/TriggerTable.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using Sirkus::Core::ActiveStep;
+using Sirkus::Core::StepData;
+using Sirkus::Core::TriggerBuffer;
+using Sirkus::Core::TriggerTable;
+
+namespace {
+
+constexpr int STEP_TICKS = Sirkus::Constants::STEP_16TH;
+
+// A pattern of numSteps sixteenths with a trigger on each of the given steps
+TriggerBuffer makeTriggers(const int numSteps, const std::vector<int>& enabledSteps, const uint8_t note = 60)
+{
+    TriggerBuffer triggers;
+    triggers.cycleTicks = numSteps * STEP_TICKS;
+    triggers.stepTicks = STEP_TICKS;
+
+    StepData data;
+    data.enabled = true;
+    data.note = note;
+    for (const int step : enabledSteps)
+        triggers.append(step * STEP_TICKS, static_cast<size_t>(step), data);
+
+    return triggers;
+}
+
+std::vector<int> ticksOf(const std::vector<ActiveStep>& steps)
+{
+    std::vector<int> ticks;
+    for (const auto& step : steps)
+        ticks.push_back(step.tick);
+    return ticks;
+}
+
+} // namespace
+
+TEST_CASE("TriggerTable's lower bound agrees with std::lower_bound", "[triggers]")
+{
+    // Repeated ticks too, steps may share one
+    TriggerBuffer triggers;
+    triggers.cycleTicks = 64;
+    for (const int tick : {0, 3, 3, 3, 8, 9, 20, 20, 41, 63})
+        triggers.append(tick, 0, StepData{});
+
+    TriggerTable table;
+    table.addTrack(makeTriggers(4, {0, 1, 2}));
+    table.addTrack(triggers);
+
+    const auto& range = table.getTrack(1);
+    for (size_t begin = range.begin; begin <= range.end; ++begin)
+    {
+        for (size_t end = begin; end <= range.end; ++end)
+        {
+            for (int tick = -1; tick <= 65; ++tick)
+            {
+                const auto first = triggers.ticks.begin() + static_cast<std::ptrdiff_t>(begin - range.begin);
+                const auto last = triggers.ticks.begin() + static_cast<std::ptrdiff_t>(end - range.begin);
+                const auto expected = static_cast<size_t>(std::lower_bound(first, last, tick) - triggers.ticks.begin());
+                REQUIRE(table.lowerBound(begin, end, tick) == expected + range.begin);
+            }
+        }
+    }
+}
+
+TEST_CASE("TriggerTable collects a track's triggers at their absolute ticks", "[triggers]")
+{
+    TriggerTable table;
+    table.addTrack(makeTriggers(16, {0, 4, 8, 12}));
+    table.addTrack(makeTriggers(4, {1, 3}, 72));
+
+    std::vector<ActiveStep> out;
+    out.reserve(64);
+
+    SECTION("inside one cycle")
+    {
+        CHECK(table.collect(0, 3 * STEP_TICKS, 6 * STEP_TICKS, out));
+        CHECK(ticksOf(out) == std::vector<int>{4 * STEP_TICKS, 8 * STEP_TICKS});
+        CHECK(out.front().triggerTick == out.front().tick);
+    }
+
+    SECTION("across the end of the pattern")
+    {
+        CHECK(table.collect(0, 14 * STEP_TICKS, 4 * STEP_TICKS, out));
+        CHECK(ticksOf(out) == std::vector<int>{16 * STEP_TICKS});
+    }
+
+    SECTION("many cycles of a short pattern, only the slot's own triggers")
+    {
+        CHECK(table.collect(1, 0, 12 * STEP_TICKS, out));
+        CHECK(ticksOf(out) == std::vector<int>{
+            1 * STEP_TICKS, 3 * STEP_TICKS, 5 * STEP_TICKS, 7 * STEP_TICKS, 9 * STEP_TICKS, 11 * STEP_TICKS});
+        CHECK(std::ranges::all_of(out, [](const ActiveStep& step) { return step.note == 72; }));
+    }
+
+    SECTION("before zero")
+    {
+        CHECK(table.collect(1, -4 * STEP_TICKS, 2 * STEP_TICKS, out));
+        CHECK(ticksOf(out) == std::vector<int>{-3 * STEP_TICKS});
+    }
+
+    SECTION("the window is half open")
+    {
+        CHECK(table.collect(0, 4 * STEP_TICKS, 4 * STEP_TICKS, out));
+        CHECK(ticksOf(out) == std::vector<int>{4 * STEP_TICKS});
+    }
+}
+
+TEST_CASE("TriggerTable plays a linked track from the range it shares", "[triggers]")
+{
+    TriggerTable table;
+    table.addTrack(makeTriggers(8, {0, 2}));
+    table.addTrack(makeTriggers(8, {5}));
+    table.addLinkedTrack(0);
+
+    REQUIRE(table.getNumTracks() == 3);
+    CHECK(table.size() == 3);
+    CHECK(table.getTrack(2).begin == table.getTrack(0).begin);
+    CHECK(table.getTrack(2).end == table.getTrack(0).end);
+
+    std::vector<ActiveStep> linked;
+    std::vector<ActiveStep> source;
+    linked.reserve(8);
+    source.reserve(8);
+    table.collect(0, 0, 8 * STEP_TICKS, source);
+    table.collect(2, 0, 8 * STEP_TICKS, linked);
+    CHECK(ticksOf(linked) == ticksOf(source));
+}
+
+TEST_CASE("TriggerTable never collects past the reserved capacity", "[triggers]")
+{
+    // A one-step pattern: a chase window over it visits every cycle the window touches
+    TriggerTable table;
+    table.addTrack(makeTriggers(1, {0}));
+
+    std::vector<ActiveStep> out;
+    out.reserve(3);
+    const auto* storage = out.data();
+
+    CHECK(table.collect(0, 0, 3 * STEP_TICKS, out));
+    CHECK_FALSE(table.collect(0, 0, 100 * STEP_TICKS, out));
+
+    CHECK(out.size() == 3);
+    CHECK(out.data() == storage);
+    CHECK(out.back().tick == 2 * STEP_TICKS);
+}